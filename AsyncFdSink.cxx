@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class AsyncFdSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "AsyncFdSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+namespace xml {
+
+AsyncFdSink::AsyncFdSink(int fd, int buffers, std::size_t buffer_size) :
+  m_fd(fd), m_buffer_size(std::max(buffer_size, max_reserve)), m_finishing(false)
+{
+  for (int i = 0; i < std::max(buffers, 2); ++i)
+  {
+    m_buffers.emplace_back(new char[m_buffer_size]);
+    m_free.push_back(m_buffers.back().get());
+  }
+  m_begin = m_pos = m_free.back();
+  m_end = m_begin + m_buffer_size;
+  m_free.pop_back();
+  m_thread = std::thread(&AsyncFdSink::write_loop, this);
+}
+
+AsyncFdSink::~AsyncFdSink()
+{
+  if (m_thread.joinable())
+    finish();
+}
+
+// Hand the current buffer over to the background thread and wait for a free one.
+void AsyncFdSink::queue_current_buffer()
+{
+  std::size_t const len = m_pos - m_begin;
+  if (len == 0)
+    return;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queue.emplace_back(m_begin, len);
+  m_condition.notify_all();
+  m_condition.wait(lock, [this]{ return !m_free.empty(); });
+  m_begin = m_pos = m_free.back();
+  m_end = m_begin + m_buffer_size;
+  m_free.pop_back();
+  m_flushed += len;
+  take_write_error();
+}
+
+// Record an error of the background thread, so that failed() and flush() report it.
+// Must be called with m_mutex locked, or after the background thread exited.
+void AsyncFdSink::take_write_error()
+{
+  if (m_write_error)
+    set_error(m_write_error.message());
+}
+
+void AsyncFdSink::overflow(std::size_t UNUSED_ARG(needed))
+{
+  // A buffer is at least max_reserve bytes, so an empty buffer always has enough room.
+  queue_current_buffer();
+}
+
+void AsyncFdSink::sync()
+{
+  queue_current_buffer();
+  // Wait until everything is written, so that flush() throws if that failed.
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_condition.wait(lock, [this]{ return m_queue.empty(); });
+  take_write_error();
+}
+
+std::error_code AsyncFdSink::finish()
+{
+  if (!m_thread.joinable())
+    return m_write_error;
+  queue_current_buffer();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finishing = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+  take_write_error();
+  m_begin = m_pos = m_end = nullptr;
+  return m_write_error;
+}
+
+void AsyncFdSink::write_loop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;)
+  {
+    m_condition.wait(lock, [this]{ return !m_queue.empty() || m_finishing; });
+    if (m_queue.empty())
+      break;
+    auto [data, len] = m_queue.front();
+    bool const failed = static_cast<bool>(m_write_error);
+    lock.unlock();
+    // After an error the remaining output is discarded.
+    char const* ptr = data;
+    std::error_code error;
+    while (!failed && len > 0)
+    {
+      ssize_t written = ::write(m_fd, ptr, len);
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        error.assign(errno, std::generic_category());
+        break;
+      }
+      ptr += written;
+      len -= written;
+    }
+    lock.lock();
+    if (error && !m_write_error)
+      m_write_error = error;
+    m_queue.pop_front();
+    m_free.push_back(data);
+    m_condition.notify_all();
+  }
+}
+
+} // namespace xml
@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class AsyncFdSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::AsyncFdSink
+ * \brief An OutputSink that writes to a file descriptor from a background thread.
+ *
+ * While the serializing thread fills one buffer, a background thread
+ * writes the previously filled buffer(s) to the file descriptor, so
+ * that serialization and disk I/O overlap. The number of buffers is
+ * bounded: when all of them are waiting to be written, the serializing
+ * thread blocks until the background thread returns one.
+ *
+ * Write errors of the background thread are picked up whenever the
+ * serializing thread hands over a buffer, after which failed() returns
+ * true. flush() (and therefore Writer::write) waits until all data was
+ * written and throws if any write failed. Call finish() after the last
+ * write to stop the background thread and to obtain the first error.
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::AsyncFdSink sink(fd);
+ * xml::Writer writer(sink);
+ * writer.write(catalog);
+ * if (std::error_code ec = sink.finish())
+ *   ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The file descriptor is not owned: it is not closed upon destruction.
+ */
+
+#pragma once
+
+#include "OutputSink.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace xml {
+
+class AsyncFdSink : public OutputSink
+{
+  private:
+    int m_fd;
+    std::size_t m_buffer_size;
+    std::vector<std::unique_ptr<char[]>> m_buffers;		// All buffers.
+
+    std::mutex m_mutex;						// Protects the members below.
+    std::condition_variable m_condition;			// Notified when a buffer is queued or returned, and upon finish().
+    std::deque<std::pair<char*, std::size_t>> m_queue;		// Filled buffers, in the order in which they must be written.
+    std::vector<char*> m_free;					// Buffers that can be filled.
+    bool m_finishing;						// Set by finish(): the background thread exits once m_queue is empty.
+    std::error_code m_write_error;				// The first error that occurred while writing.
+
+    std::thread m_thread;
+
+  public:
+    /**
+      * \brief Construct an AsyncFdSink that writes to \a fd.
+      *
+      * \param fd : the file descriptor to write to.
+      * \param buffers : the number of buffers; at least two.
+      * \param buffer_size : the size of each buffer.
+      */
+    AsyncFdSink(int fd, int buffers = 2, std::size_t buffer_size = default_buffer_size);
+
+    /// Calls finish() if that wasn't done yet, ignoring errors.
+    ~AsyncFdSink() override;
+
+    /**
+      * \brief Write all remaining data and stop the background thread.
+      *
+      * Nothing may be written to the sink anymore afterwards.
+      * Calling finish() again just returns the same error.
+      *
+      * \returns The first write error that occurred, if any.
+      */
+    std::error_code finish();
+
+  protected:
+    void overflow(std::size_t needed) override;
+    void sync() override;
+
+  private:
+    void queue_current_buffer();
+    void take_write_error();
+    void write_loop();
+};
+
+} // namespace xml
@@ -24,6 +24,9 @@
 #include "sys.h"
 #include "ReadBridge.h"
 #include "debug.h"
+#include <boost/filesystem/operations.hpp>
+
+namespace fs = boost::filesystem;
 
 namespace xml {
 
@@ -44,14 +47,40 @@ void Bridge::set_version(uint32_t version_major)
   m_state.m_version_major = version_major;
 }
 
+//static
+void Bridge::open_file(std::ifstream& file, fs::path const& filepath)
+{
+  try
+  {
+    if (!exists(filepath))
+    {
+      using namespace boost::system;
+      throw fs::filesystem_error("", filepath, "", error_code(errc::no_such_file_or_directory, generic_category()));
+    }
+  }
+  catch (fs::filesystem_error const& ex)
+  {
+    THROW_ALERT("fs::open: [ERROR]", AIArgs("[ERROR]", ex.what()));
+  }
+  file.open(filepath.c_str(), std::ios_base::binary);
+  if (!file)
+  {
+    THROW_ALERT("fs::open: failed to open \"[FILE]\".", AIArgs("[FILE]", filepath.string()));
+  }
+}
+
 void Bridge::push_state()
 {
   m_state_stack.push(m_state);
   ++m_state.m_depth;
+  if (m_profiler)
+    m_profiler->open(profiler_bytes());
 }
 
 void Bridge::pop_state()
 {
+  if (m_profiler)
+    m_profiler->close(profiler_bytes());
 #ifdef CWDEBUG
   uint32_t version = m_state.m_version_major;
 #endif
@@ -71,6 +100,11 @@ void Bridge::pop_state()
 #endif
 }
 
+void Bridge::write_children_elements(std::size_t count, write_range_type const& write_range)
+{
+  write_range(*this, 0, count);
+}
+
 // Virtual functions only implemented in ReadBridge:
 
 void Bridge::get_element()
@@ -83,19 +117,29 @@ void Bridge::next_child()
   DoutFatal(dc::core, "Calling WriteBridge::next_child()!?");
 }
 
-bool Bridge::read_attribute(char const* UNUSED_ARG(name), std::string& UNUSED_ARG(attribute_str), bool UNUSED_ARG(mandatory)) const
+bool Bridge::read_attribute(char const* UNUSED_ARG(name), std::string_view& UNUSED_ARG(attribute_str), bool UNUSED_ARG(mandatory)) const
 {
   DoutFatal(dc::core, "Calling WriteBridge::read_attribute()!?");
 }
 
-std::string Bridge::read_child_stream()
+std::string_view Bridge::read_child_stream()
 {
   DoutFatal(dc::core, "Calling WriteBridge::read_child_stream()!?");
 }
 
+uint64_t Bridge::profiler_bytes() const
+{
+  return 0;
+}
+
+std::size_t Bridge::children_count_hint() const
+{
+  return 0;
+}
+
 // Virtual functions only implemented in WriteBridge:
 
-void Bridge::write_attribute(char const* UNUSED_ARG(name), std::string const& UNUSED_ARG(raw_attribute))
+void Bridge::write_attribute(char const* UNUSED_ARG(name), std::string_view UNUSED_ARG(raw_attribute))
 {
   DoutFatal(dc::core, "Calling ReadBridge::write_attribute()!?");
 }
@@ -103,6 +103,26 @@
  * for `std::string` to make it read all characters, including
  * whitespace.
  *
+ * When reading, the elements do not have to be stored in a container either:
+ * passing a callable that takes the element type (by value or reference)
+ * instead of a container hands each element to that callable as soon as it
+ * is deserialized, after which it is destroyed.
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml.children("rows", [&](Row&& row){ if (row.selected()) total += row.amount(); });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * When writing, the elements do not have to be stored in a container:
+ * `write_children` and `write_children_stream` accept any range, or a
+ * generator that returns a `std::optional` (or a pointer) per call and
+ * `std::nullopt` (or `nullptr`) after the last element. Each element
+ * is serialized as soon as it is produced, and the output is identical
+ * to that of `children` and `children_stream` respectively.
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml.write_children("rows", [&]() -> std::optional<Row> { return cursor.next(); });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
  * Example Code
  * ------------
  *
@@ -307,12 +327,23 @@
 #include "write_to_string.h"
 #include "read_from_stream.h"
 #include "write_to_stream.h"
+#include "MemoryAccounting.h"
+#include "Profiler.h"
+#include "Tracer.h"
 
 #include "utils/AIAlert.h"
 #include "debug.h"
 
 #include <libxml++/libxml++.h>
+#include <boost/filesystem/path.hpp>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <stack>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #if defined(CWDEBUG) && !defined(DOXYGEN)
 NAMESPACE_DEBUG_CHANNELS_START
@@ -354,6 +385,55 @@ enum assign_method_type {
   assign
 };
 
+/// @cond Doxygen_Suppress
+template<typename F>
+struct visitor_argument_of_member { };
+
+template<typename R, typename C, typename A>
+struct visitor_argument_of_member<R (C::*)(A)> { using type = A; };
+
+template<typename R, typename C, typename A>
+struct visitor_argument_of_member<R (C::*)(A) const> { using type = A; };
+
+// The type of the single argument of the callable F: a class with a non-template operator(), or a function (pointer).
+template<typename F, typename = void>
+struct visitor_argument { };
+
+template<typename F>
+struct visitor_argument<F, std::void_t<decltype(&F::operator())>> : visitor_argument_of_member<decltype(&F::operator())> { };
+
+template<typename R, typename A>
+struct visitor_argument<R (*)(A)> { using type = A; };
+
+template<typename R, typename A>
+struct visitor_argument<R (A)> { using type = A; };
+
+template<typename F, typename = void>
+constexpr bool is_visitor_impl = false;
+
+template<typename F>
+constexpr bool is_visitor_impl<F, std::void_t<typename visitor_argument<F>::type>> = true;
+
+// True if F is something that can be passed as visitor to Bridge::children and Bridge::children_stream.
+template<typename F>
+constexpr bool is_visitor = is_visitor_impl<std::remove_cv_t<std::remove_reference_t<F>>>;
+
+// The element type of visitor F.
+template<typename F>
+using visitor_element_type = std::remove_cv_t<std::remove_reference_t<typename visitor_argument<std::remove_cv_t<std::remove_reference_t<F>>>::type>>;
+
+// Pass obj to visitor; moved, unless the visitor takes a non-const lvalue reference.
+template<typename VISITOR, typename T>
+void call_visitor(VISITOR& visitor, T& obj)
+{
+  using argument_type = typename visitor_argument<std::remove_cv_t<std::remove_reference_t<VISITOR>>>::type;
+  if constexpr (std::is_lvalue_reference_v<argument_type> && !std::is_const_v<std::remove_reference_t<argument_type>>)
+    visitor(obj);
+  else
+    visitor(std::move(obj));
+}
+/// @endcond
+
 class Bridge
 {
   protected:
@@ -382,6 +462,10 @@ class Bridge
 				  * a different name.
 				  */
     std::stack<state_type> m_state_stack;	///< Internal stack with state information.
+    std::unique_ptr<MemoryAccounting> m_memory_accounting;	///< Memory accounting, or null when not enabled.
+    Profiler* m_profiler = nullptr;				///< The profiler, or null when not profiling.
+    bool m_string_views = false;				///< Set when reading into std::string_view variables is allowed.
+    int m_root_depth = 0;					///< The value of m_state.m_depth while processing the root element.
 
   protected:
     /** \brief Construct a Bridge.
@@ -397,6 +481,9 @@ class Bridge
     /// Pop state information from stack.
     void pop_state();
 
+    /// Open \a filepath for reading in binary mode; throws AIAlert::Error if it doesn't exist or can't be opened.
+    static void open_file(std::ifstream& file, boost::filesystem::path const& filepath);
+
   public:
     /** \brief Accessor for the current version.
       * This version is initially set to the value that was passed to Reader::parse.
@@ -511,7 +598,7 @@ class Bridge
       * \param container : a reference to the corresponding container to read from / write to.
       * \param method : set this to 'xml::insert' when you want use 'insert' to add elements to \a container instead of push_back.
       */
-    template<typename CONTAINER, typename METHOD = push_back_method_type>
+    template<typename CONTAINER, typename METHOD = push_back_method_type, typename = std::enable_if_t<!is_visitor<CONTAINER>>>
       void children(char const* name, CONTAINER& container, METHOD method = push_back);
 
     /** \brief Read or write a list of child elements with the same \a name to or from a std container.
@@ -524,9 +611,69 @@ class Bridge
       * if this is not possible and the default istream/ostream operator is not sufficient, then
       * specialize xml::read_from_stream / xml::write_to_stream for this type.
       */
-    template<typename CONTAINER, typename METHOD = push_back_method_type>
+    template<typename CONTAINER, typename METHOD = push_back_method_type, typename = std::enable_if_t<!is_visitor<CONTAINER>>>
       void children_stream(char const* name, CONTAINER& container, METHOD method = push_back);
 
+    /** \brief Read a list of child elements with the same name and pass each of them to \a visitor.
+      * \param name : the name of the element.
+      * \param visitor : a callable with a single parameter of the (non-deduced) element type, for example `[](T&& obj){ ... }`.
+      *
+      * Each element is deserialized into a newly constructed object that is passed to \a visitor
+      * (as rvalue) and destroyed afterwards. Can only be used when reading.
+      */
+    template<typename VISITOR, typename = std::enable_if_t<is_visitor<VISITOR>>>
+      void children(char const* name, VISITOR&& visitor);
+
+    /** \brief Read a list of child elements with the same \a name using read_from_stream and pass each of them to \a visitor.
+      * \param name : the name of the elements.
+      * \param visitor : a callable with a single parameter of the (non-deduced) element type, for example `[](int value){ ... }`.
+      *
+      * Can only be used when reading.
+      */
+    template<typename VISITOR, typename = std::enable_if_t<is_visitor<VISITOR>>>
+      void children_stream(char const* name, VISITOR&& visitor);
+
+    /** \brief Write a list of child elements with the same name, produced by \a source.
+      * \param name : the name of the element.
+      * \param source : a range, or a generator that returns a `std::optional` or pointer per element and `std::nullopt` or `nullptr` at the end.
+      *
+      * Writes the same XML as children(name, container) would for a container holding the same elements,
+      * without the need to store all elements at once. Can only be used when writing.
+      * Because the elements are written with their (non-const) xml(Bridge&), a range must give
+      * non-const access to them: a const range, or a generator returning pointers to const, doesn't compile.
+      */
+    template<typename SOURCE>
+      void write_children(char const* name, SOURCE&& source);
+
+    /** \brief Write a list of child elements with the same \a name, produced by \a source, using write_to_stream.
+      * \param name : the name of the elements.
+      * \param source : a range, or a generator that returns a `std::optional` or pointer per element and `std::nullopt` or `nullptr` at the end.
+      *
+      * Writes the same XML as children_stream(name, container) would for a container holding the same elements.
+      * Can only be used when writing.
+      */
+    template<typename SOURCE>
+      void write_children_stream(char const* name, SOURCE&& source);
+
+    /// Start accounting the memory used by this Reader or Writer; see MemoryAccounting.
+    void enable_memory_accounting() { if (!m_memory_accounting) m_memory_accounting = std::make_unique<MemoryAccounting>(); }
+    /// Return the memory accounting results, or null if enable_memory_accounting() wasn't called.
+    MemoryAccounting const* memory_accounting() const { return m_memory_accounting.get(); }
+
+    /// Accumulate per element timing and counters in \a profiler (null turns profiling off); see Profiler.
+    void set_profiler(Profiler* profiler) { m_profiler = profiler; }
+    /// Return the profiler that was passed to set_profiler().
+    Profiler* profiler() const { return m_profiler; }
+
+    /**
+      * \brief Allow reading attributes and text into `std::string_view` variables, which then refer to the parsed document.
+      *
+      * The views are only valid as long as the document is: until the next parse, Reader::release(),
+      * or the destruction of the Reader. Don't combine this with Reader::set_release_consumed.
+      * Without this, reading a `std::string_view` throws.
+      */
+    void set_string_views(bool string_views) { m_string_views = string_views; }
+
     /// Set a user pointer.
     void set_user_ptr(void* user_ptr) { m_state.m_user_ptr = user_ptr; }
     /// Get the user pointer that was set with set_user_ptr().
@@ -551,28 +698,68 @@ class Bridge
     // Virtual functions implemented in ReadBridge:
     virtual void get_element();
     virtual void next_child();
-    virtual bool read_attribute(char const* name, std::string& attribute_str, bool mandatory) const;
-    virtual std::string read_child_stream();
+    // The returned views refer to the document, and are valid at least until the next call.
+    virtual bool read_attribute(char const* name, std::string_view& attribute_str, bool mandatory) const;
+    virtual std::string_view read_child_stream();
+    // Return the number of child elements that children() or children_stream() is about to read (an upper bound), or zero if unknown.
+    virtual std::size_t children_count_hint() const;
     // Virtual functions only implemented in WriteBridge:
     virtual std::ostream& get_os();
-    virtual void write_attribute(char const* name, std::string const& raw_attribute);
+    virtual void write_attribute(char const* name, std::string_view raw_attribute);
+
+    // Write attribute \a name with value \a attribute: strings as-is, everything else with write_to_string.
+    template<typename T>
+      void write_attribute_value(char const* name, T const& attribute);
+
+    // Tell the profiler, if any, that an element with name starts.
+    void profile_element(std::string_view name) { if (m_profiler) m_profiler->element(name, profiler_bytes()); }
+    // Return the number of bytes written so far, for the profiler.
+    virtual uint64_t profiler_bytes() const;
+
+    // Read var from the attribute value or text str; see read_from_view.
+    template<typename T>
+      void read_value(T& var, std::string_view str) const;
+    // Read var from the text str of an element: strings directly, other types with read_from_stream. Returns false if that failed.
+    template<typename T>
+      bool read_text(T& var, std::string_view str) const;
+
+    // Call obj.xml(*this), or serialize(obj, *this) when T has no xml member function.
+    template<typename T>
+      void xml_element(T& obj);
+
+    // Write the elements [0, count) of a container passed to children(), by calling write_range(bridge, first, last)
+    // for one or more consecutive ranges [first, last). The default calls write_range(*this, 0, count).
+    using write_range_type = std::function<void(Bridge& bridge, std::size_t first, std::size_t last)>;
+    virtual void write_children_elements(std::size_t count, write_range_type const& write_range);
     virtual void write_child_stream(std::string const& element);
 /// @endcond
 };
 
+// Write an attribute: the standard string types are passed on as-is and all other types go
+// through write_to_string, which might be specialized for them. The default write_to_string
+// formats arithmetic types with std::to_chars; the result fits in the small string buffer.
+template<typename T>
+void Bridge::write_attribute_value(char const* name, T const& attribute)
+{
+  if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, char const*>)
+    write_attribute(name, std::string_view(attribute));
+  else
+    write_attribute(name, write_to_string(attribute));
+}
+
 // Read or write mandatory attribute.
 template<typename T>
 void Bridge::attribute(char const* name, T& attribute)
 {
   if (writing())
   {
-    write_attribute(name, write_to_string(attribute));
+    write_attribute_value(name, attribute);
   }
   else
   {
-    std::string attribute_str;
+    std::string_view attribute_str;
     read_attribute(name, attribute_str, true);
-    read_from_string(attribute, attribute_str);
+    read_value(attribute, attribute_str);
   }
 }
 
@@ -584,18 +771,17 @@ attribute_return_type Bridge::optional_attribute(char const* name, T& attribute,
   {
     if (always_write || attribute != default_value)
     {
-      std::string attribute_str = write_to_string(attribute);
-      write_attribute(name, attribute_str);
+      write_attribute_value(name, attribute);
       return writing_attribute_success;
     }
     return writing_attribute_skipped;
   }
   else
   {
-    std::string attribute_str;
+    std::string_view attribute_str;
     if (read_attribute(name, attribute_str, false))
     {
-      read_from_string(attribute, attribute_str);
+      read_value(attribute, attribute_str);
       return reading_attribute_success;
     }
     else
@@ -607,6 +793,35 @@ attribute_return_type Bridge::optional_attribute(char const* name, T& attribute,
   }
 }
 
+template<typename T>
+void Bridge::read_value(T& var, std::string_view str) const
+{
+  if constexpr (std::is_same_v<T, std::string_view>)
+  {
+    if (!m_string_views)
+    {
+      THROW_ALERT("Reading into a std::string_view requires set_string_views(true).");
+    }
+  }
+  read_from_view(var, str);
+}
+
+template<typename T>
+bool Bridge::read_text(T& var, std::string_view str) const
+{
+  if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+  {
+    read_value(var, str);
+    return true;
+  }
+  else
+  {
+    std::istringstream iss{std::string(str)};
+    read_from_stream(iss, var);
+    return !iss.fail();
+  }
+}
+
 /// @cond Doxygen_Suppress
 //  Internal stuff.
 
@@ -634,15 +849,23 @@ void serialize(T& obj, Bridge& xml)
   static_assert(std::is_integral_v<T>, "Please specialize `serialize` for this T.");
 }
 
-// Read or write a child element using xml(Bridge&).
 template<typename T>
-void Bridge::child(T& obj)
+void Bridge::xml_element(T& obj)
 {
-  open_child();
   if constexpr (has_xml<T>)
     obj.xml(*this);
   else
     serialize(obj, *this);
+  if (m_memory_accounting)
+    m_memory_accounting->count_object(sizeof(T));
+}
+
+// Read or write a child element using xml(Bridge&).
+template<typename T>
+void Bridge::child(T& obj)
+{
+  open_child();
+  xml_element(obj);
   close_child();
 }
 
@@ -669,8 +892,7 @@ element_return_type Bridge::text_stream(T& var)
   else
   {
     get_element();
-    std::istringstream iss(read_child_stream());
-    read_from_stream(iss, var);
+    read_text(var, read_child_stream());
     ret = reading_element_success;
   }
   return ret;
@@ -740,70 +962,179 @@ element_return_type Bridge::child(T& obj, T const& default_value, bool always_wr
 //  Internal stuff.
 
 template<typename CONTAINER>
-void container_add(CONTAINER& container, typename CONTAINER::value_type const& value, insert_method_type)
+void container_add(CONTAINER& container, typename CONTAINER::value_type&& value, insert_method_type)
 {
-  container.insert(value);
+  container.insert(std::move(value));
 }
 
 template<typename CONTAINER>
-void container_add(CONTAINER& container, typename CONTAINER::value_type const& value, push_back_method_type)
+void container_add(CONTAINER& container, typename CONTAINER::value_type&& value, push_back_method_type)
 {
-  container.push_back(value);
+  container.push_back(std::move(value));
 }
 
 template<typename CONTAINER>
-void container_add(CONTAINER& container, typename CONTAINER::value_type const& value, int index)
+void container_add(CONTAINER& container, typename CONTAINER::value_type&& value, int index)
+{
+  container[index] = std::move(value);
+}
+
+template<typename CONTAINER, typename = void>
+constexpr bool has_reserve = false;
+
+template<typename CONTAINER>
+constexpr bool has_reserve<CONTAINER, std::void_t<decltype(std::declval<CONTAINER&>().reserve(std::size_t{}))>> = true;
+
+template<typename CONTAINER, typename = void>
+constexpr bool can_emplace_back = false;
+
+// Only when emplace_back() returns a reference to the new element (C++17) and pop_back() exists.
+template<typename CONTAINER>
+constexpr bool can_emplace_back<CONTAINER, std::void_t<decltype(std::declval<CONTAINER&>().pop_back())>> =
+    std::is_same_v<decltype(std::declval<CONTAINER&>().emplace_back()), typename CONTAINER::value_type&>;
+
+template<typename CONTAINER, typename = void>
+constexpr bool has_size = false;
+
+template<typename CONTAINER>
+constexpr bool has_size<CONTAINER, std::void_t<decltype(std::declval<CONTAINER const&>().size())>> = true;
+
+template<typename CONTAINER>
+std::size_t container_size(CONTAINER const& container)
 {
-  container[index] = value;
+  if constexpr (has_size<CONTAINER>)
+    return container.size();
+  else
+    return std::distance(container.begin(), container.end());
+}
+
+template<typename SOURCE, typename = void>
+constexpr bool is_range = false;
+
+template<typename SOURCE>
+constexpr bool is_range<SOURCE, std::void_t<decltype(std::begin(std::declval<SOURCE&>())), decltype(std::end(std::declval<SOURCE&>()))>> = true;
+
+// Call f(element) for every element of source, which is either a range or a generator
+// that returns something that converts to false after the last element (std::nullopt or nullptr).
+template<typename SOURCE, typename F>
+void for_each_element(SOURCE& source, F const& f)
+{
+  if constexpr (is_range<SOURCE>)
+  {
+    for (auto&& element : source)
+      f(element);
+  }
+  else
+  {
+    for (;;)
+    {
+      auto element = source();
+      if (!element)
+        break;
+      f(*element);
+    }
+  }
 }
 
 /// @endcond
 
 // Read or write a list of child elements with the same name to or from a std container.
-template<typename CONTAINER, typename METHOD>
+template<typename CONTAINER, typename METHOD, typename>
 void Bridge::children(char const* name, CONTAINER& container, METHOD method)
 {
+  Tracer::Scope trace(name, m_state.m_depth - m_root_depth);
   open_child();
   node_name(name);
   open_child();
   if (writing())
   {
-    for (typename CONTAINER::iterator iter = container.begin(); iter != container.end(); ++iter)
-    {
-      if constexpr (has_xml<typename CONTAINER::value_type>)
-        iter->xml(*this);
-      else
-        serialize(*iter, *this);
-    }
+    write_children_elements(container_size(container), [&container](Bridge& bridge, std::size_t first, std::size_t last){
+      typename CONTAINER::iterator iter = std::next(container.begin(), first);
+      for (std::size_t i = first; i < last; ++i, ++iter)
+        bridge.xml_element(*iter);
+    });
   }
   else
   {
     int depth = m_state.m_depth;
+    constexpr bool emplace = std::is_same_v<METHOD, push_back_method_type> && can_emplace_back<CONTAINER>;
+    // When emplacing, the last attempt (that finds no child left) needs room for one extra element.
+    if constexpr (has_reserve<CONTAINER>)
+      container.reserve(container_size(container) + children_count_hint() + (emplace ? 1 : 0));
     for(;;)
     {
-      typename CONTAINER::value_type obj;
-      try
+      if constexpr (emplace)
       {
-        if constexpr (has_xml<typename CONTAINER::value_type>)
-          obj.xml(*this);
-        else
-          serialize(obj, *this);
+        // Deserialize directly into a new element at the end, and remove it again if that fails.
+        typename CONTAINER::value_type& obj = container.emplace_back();
+        try
+        {
+          xml_element(obj);
+        }
+        catch (NoChildLeft const&)
+        {
+          container.pop_back();
+          if (m_state.m_depth != depth)
+            throw;
+          break;
+        }
+        catch (...)
+        {
+          container.pop_back();
+          throw;
+        }
       }
-      catch (NoChildLeft const&)
+      else
       {
-	if (m_state.m_depth != depth)
-	  throw;
-	break;
+        typename CONTAINER::value_type obj;
+        try
+        {
+          xml_element(obj);
+        }
+        catch (NoChildLeft const&)
+        {
+          if (m_state.m_depth != depth)
+            throw;
+          break;
+        }
+        container_add(container, std::move(obj), method);
       }
-      container_add(container, obj, method);
     }
   }
   close_child();
   close_child();
 }
 
+// Write a list of child elements with the same name from a range or generator.
+template<typename SOURCE>
+void Bridge::write_children(char const* name, SOURCE&& source)
+{
+  ASSERT(writing());
+  Tracer::Scope trace(name, m_state.m_depth - m_root_depth);
+  open_child();
+  node_name(name);
+  open_child();
+  for_each_element(source, [this](auto& element){ xml_element(element); });
+  close_child();
+  close_child();
+}
+
+// Write a list of child elements with the same name from a range or generator using write_to_stream for the child elements.
+template<typename SOURCE>
+void Bridge::write_children_stream(char const* name, SOURCE&& source)
+{
+  ASSERT(writing());
+  open_child(name);
+  for_each_element(source, [this](auto const& element){
+    std::ostringstream oss;
+    write_to_stream(oss, element);
+    write_child_stream(oss.str());
+  });
+  close_child();
+}
+
 // Read or write a list of child elements with the same name to or from a std container using read_from_stream / write_to_stream for the child elements.
-template<typename CONTAINER, typename METHOD>
+template<typename CONTAINER, typename METHOD, typename>
 void Bridge::children_stream(char const* name, CONTAINER& container, METHOD method)
 {
   if (writing())
@@ -822,21 +1153,21 @@ void Bridge::children_stream(char const* name, CONTAINER& container, METHOD meth
     try
     {
       open_child(name);	// This might throw NoChildLeft, but even then we still need to call close_child().
+      if constexpr (has_reserve<CONTAINER>)
+        container.reserve(container_size(container) + children_count_hint());
       for (int i = 0;; ++i)
       {
 	typename CONTAINER::value_type var;
-	std::string str = read_child_stream();
-	std::istringstream iss(str);
-	read_from_stream(iss, var);
-	if (iss.fail())
+	std::string_view str = read_child_stream();
+	if (!read_text(var, str))
 	{
 	  THROW_ALERT("Failed to read contents of element <[NAME]> from string \"[STRING]\".",
-	      AIArgs("[NAME]", name)("[STRING]", str));
+	      AIArgs("[NAME]", name)("[STRING]", std::string(str)));
 	}
         if constexpr (std::is_same_v<METHOD, assign_method_type>)
-	  container_add(container, var, i);
+	  container_add(container, std::move(var), i);
         else
-          container_add(container, var, method);
+          container_add(container, std::move(var), method);
 	next_child();
       }
     }
@@ -849,4 +1180,63 @@ void Bridge::children_stream(char const* name, CONTAINER& container, METHOD meth
   close_child();
 }
 
+// Read a list of child elements with the same name and pass each of them to visitor.
+template<typename VISITOR, typename>
+void Bridge::children(char const* name, VISITOR&& visitor)
+{
+  ASSERT(!writing());
+  Tracer::Scope trace(name, m_state.m_depth - m_root_depth);
+  open_child();
+  node_name(name);
+  open_child();
+  int depth = m_state.m_depth;
+  for(;;)
+  {
+    visitor_element_type<VISITOR> obj;
+    try
+    {
+      xml_element(obj);
+    }
+    catch (NoChildLeft const&)
+    {
+      if (m_state.m_depth != depth)
+        throw;
+      break;
+    }
+    call_visitor(visitor, obj);
+  }
+  close_child();
+  close_child();
+}
+
+// Read a list of child elements with the same name using read_from_stream and pass each of them to visitor.
+template<typename VISITOR, typename>
+void Bridge::children_stream(char const* name, VISITOR&& visitor)
+{
+  ASSERT(!writing());
+  int depth = m_state.m_depth;
+  try
+  {
+    open_child(name);	// This might throw NoChildLeft, but even then we still need to call close_child().
+    for (;;)
+    {
+      visitor_element_type<VISITOR> var;
+      std::string_view str = read_child_stream();
+      if (!read_text(var, str))
+      {
+        THROW_ALERT("Failed to read contents of element <[NAME]> from string \"[STRING]\".",
+            AIArgs("[NAME]", name)("[STRING]", std::string(str)));
+      }
+      call_visitor(visitor, var);
+      next_child();
+    }
+  }
+  catch (NoChildLeft const&)
+  {
+    if (m_state.m_depth != depth + 1)
+      throw;
+  }
+  close_child();
+}
+
 } // namespace xml
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class ElementPath.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "ElementPath.h"
+#include "utils/AIAlert.h"
+#include <libxml++/libxml++.h>
+#include <libxml++/nodes/element.h>
+#include <cstdlib>
+
+namespace xml {
+
+ElementPath::ElementPath(std::string_view expression)
+{
+  std::string_view const full_expression = expression;
+  auto syntax_error = [&full_expression](char const* what){
+    THROW_ALERT("Invalid element path \"[PATH]\": [WHAT].", AIArgs("[PATH]", std::string(full_expression))("[WHAT]", what));
+  };
+  if (!expression.empty() && expression.front() == '/')
+    expression.remove_prefix(1);
+  for (;;)
+  {
+    Step step;
+    std::size_t end = expression.find_first_of("[/");
+    std::string_view name = expression.substr(0, end);
+    if (name.empty())
+      syntax_error("empty step");
+    if (name.find_first_of("]@='\" ") != std::string_view::npos)
+      syntax_error("invalid character in element name");
+    if (name != "*")
+      step.m_name = name;
+    expression.remove_prefix(name.size());
+    while (!expression.empty() && expression.front() == '[')
+    {
+      // The closing ']' comes after the quoted value of an attribute test, which may contain a ']' itself.
+      std::size_t close = expression.find_first_of("=]");
+      if (close != std::string_view::npos && expression[close] == '=' && close + 1 < expression.size() &&
+          (expression[close + 1] == '\'' || expression[close + 1] == '"'))
+      {
+        std::size_t end_quote = expression.find(expression[close + 1], close + 2);
+        if (end_quote == std::string_view::npos)
+          syntax_error("missing closing quote");
+        close = end_quote + 1;
+      }
+      if (close != std::string_view::npos)
+        close = expression.find(']', close);
+      if (close == std::string_view::npos)
+        syntax_error("missing ']'");
+      std::string_view predicate = expression.substr(1, close - 1);
+      Predicate pred{0, {}, false, {}};
+      if (!predicate.empty() && predicate.front() == '@')
+      {
+        std::size_t is = predicate.find('=');
+        pred.m_attribute = predicate.substr(1, is == std::string_view::npos ? std::string_view::npos : is - 1);
+        if (pred.m_attribute.empty())
+          syntax_error("empty attribute name");
+        if (is != std::string_view::npos)
+        {
+          std::string_view value = predicate.substr(is + 1);
+          if (value.size() < 2 || (value.front() != '\'' && value.front() != '"') || value.back() != value.front())
+            syntax_error("attribute value must be quoted");
+          pred.m_has_value = true;
+          pred.m_value = value.substr(1, value.size() - 2);
+        }
+      }
+      else
+      {
+        char* end_ptr;
+        std::string position(predicate);
+        pred.m_position = std::strtol(position.c_str(), &end_ptr, 10);
+        if (position.empty() || *end_ptr != 0 || pred.m_position < 1)
+          syntax_error("a predicate must be a positive position or an attribute test");
+      }
+      step.m_predicates.push_back(std::move(pred));
+      expression.remove_prefix(close + 1);
+    }
+    if (!expression.empty() && expression.front() != '/')
+      syntax_error("expected '/' or '['");
+    m_steps.push_back(std::move(step));
+    if (expression.empty())
+      break;
+    expression.remove_prefix(1);	// Skip the '/'.
+  }
+}
+
+// Apply step to candidates (the elements that match the name test of step, in document order),
+// then continue with the children of the remaining candidates.
+bool ElementPath::match_from(std::size_t step, std::vector<xmlpp::Element const*>& candidates, std::function<bool(xmlpp::Element const*)> const& f) const
+{
+  for (Predicate const& predicate : m_steps[step].m_predicates)
+  {
+    if (predicate.m_position)
+    {
+      if (predicate.m_position > static_cast<int>(candidates.size()))
+        candidates.clear();
+      else
+        candidates = { candidates[predicate.m_position - 1] };
+      continue;
+    }
+    std::vector<xmlpp::Element const*> remaining;
+    for (xmlpp::Element const* element : candidates)
+    {
+      xmlpp::Attribute const* attribute = element->get_attribute(predicate.m_attribute);
+      if (attribute && (!predicate.m_has_value || attribute->get_value() == predicate.m_value))
+        remaining.push_back(element);
+    }
+    candidates.swap(remaining);
+  }
+  bool const last = step + 1 == m_steps.size();
+  for (xmlpp::Element const* element : candidates)
+  {
+    if (last)
+    {
+      if (!f(element))
+        return false;
+      continue;
+    }
+    std::vector<xmlpp::Element const*> children;
+    for (xmlpp::Node const* node : element->get_children(m_steps[step + 1].m_name))
+      if (xmlpp::Element const* child = dynamic_cast<xmlpp::Element const*>(node))
+        children.push_back(child);
+    if (!match_from(step + 1, children, f))
+      return false;
+  }
+  return true;
+}
+
+bool ElementPath::for_each_match(xmlpp::Element const* root, std::function<bool(xmlpp::Element const*)> const& f) const
+{
+  std::vector<xmlpp::Element const*> candidates;
+  if (root && (m_steps[0].m_name.empty() || root->get_name() == m_steps[0].m_name))
+    candidates.push_back(root);
+  return match_from(0, candidates, f);
+}
+
+} // namespace xml
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class ElementPath.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::ElementPath
+ * \brief A compiled, XPath-like expression that selects elements of a document.
+ *
+ * The expression is a list of steps separated by slashes. The first step
+ * selects the root element, every following step selects child elements
+ * of the elements selected by the previous step. A leading slash is optional.
+ * Every step is an element name, or `*` for any element, followed by
+ * zero or more predicates:
+ *   - `[N]` : only the N-th (1-based) of the elements selected so far by this step;
+ *   - `[@name='value']` or `[@name="value"]` : only elements with an attribute \a name equal to \a value (which may contain a `]`, but not the quote);
+ *   - `[@name]` : only elements that have an attribute \a name.
+ *
+ * Predicates are applied from left to right. For example,
+ * `/catalog/product[@product_image='cardigan.jpg']/catalog_item[2]`.
+ *
+ * See Reader::read_at.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xmlpp {
+class Element;
+} // namespace xmlpp
+
+namespace xml {
+
+class ElementPath
+{
+  private:
+    struct Predicate
+    {
+      int m_position;			// The required 1-based position, or zero for an attribute predicate.
+      std::string m_attribute;		// The name of the attribute.
+      bool m_has_value;			// False for [@name].
+      std::string m_value;		// The required value of the attribute.
+    };
+
+    struct Step
+    {
+      std::string m_name;		// The element name, or empty for '*'.
+      std::vector<Predicate> m_predicates;
+    };
+
+    std::vector<Step> m_steps;
+
+  public:
+    /// Compile \a expression; throws AIAlert::Error upon a syntax error.
+    ElementPath(std::string_view expression);
+
+    /**
+      * \brief Call \a f for every element below \a root (inclusive) that matches, in document order.
+      *
+      * \a f returns false to stop the search.
+      *
+      * \returns False if the search was stopped by \a f.
+      */
+    bool for_each_match(xmlpp::Element const* root, std::function<bool(xmlpp::Element const*)> const& f) const;
+
+  private:
+    bool match_from(std::size_t step, std::vector<xmlpp::Element const*>& candidates, std::function<bool(xmlpp::Element const*)> const& f) const;
+};
+
+} // namespace xml
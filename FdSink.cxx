@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class FdSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "FdSink.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace xml {
+
+FdSink::~FdSink()
+{
+  sync();
+}
+
+void FdSink::write_out(char const* data, std::size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t written = ::write(m_fd, data, len);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      set_error(std::strerror(errno));
+      return;
+    }
+    data += written;
+    len -= written;
+  }
+}
+
+} // namespace xml
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class FdSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::FdSink
+ * \brief An OutputSink that writes to a file descriptor.
+ *
+ * The file descriptor is not owned: it is not closed upon destruction.
+ */
+
+#pragma once
+
+#include "OutputSink.h"
+
+namespace xml {
+
+class FdSink : public BufferedSink
+{
+  private:
+    int m_fd;
+
+  public:
+    /// Construct an FdSink that writes to \a fd, using a buffer of \a buffer_size bytes.
+    FdSink(int fd, std::size_t buffer_size = default_buffer_size) : BufferedSink(buffer_size), m_fd(fd) { }
+
+    /// Flush the buffer, ignoring errors.
+    ~FdSink() override;
+
+  protected:
+    void write_out(char const* data, std::size_t len) override;
+};
+
+} // namespace xml
@@ -0,0 +1,238 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class FileSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "FileSink.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = boost::filesystem;
+
+namespace xml {
+
+FileSink::FileSink(fs::path const& path, uint64_t size_estimate, mode_type mode, std::size_t buffer_size) :
+  m_path(path), m_fd(-1), m_mode(mode), m_capacity(0), m_buffer(nullptr)
+{
+  if (size_estimate == 0)
+  {
+    boost::system::error_code ec;
+    uintmax_t existing_size = fs::file_size(path, ec);
+    if (!ec)
+      size_estimate = existing_size;
+  }
+
+  // Create a new, unique file next to the target; O_EXCL guarantees that we don't clobber anything.
+  // Contrary to mkstemp, passing 0666 to open lets the umask determine the permissions, like std::ofstream does.
+  static std::atomic<unsigned int> s_counter;
+  for (int attempt = 0; m_fd == -1; ++attempt)
+  {
+    m_temp_path = path;
+    m_temp_path += ".tmp." + std::to_string(::getpid()) + "." + std::to_string(s_counter++);
+    m_fd = ::open(m_temp_path.c_str(), (mode == mapped ? O_RDWR : O_WRONLY) | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (m_fd == -1 && (errno != EEXIST || attempt == 100))
+    {
+      THROW_ALERT("Failed to create temporary file \"[FILE]\": [ERROR]", AIArgs("[FILE]", m_temp_path.string())("[ERROR]", std::strerror(errno)));
+    }
+  }
+
+  // Preallocate the disk space. This is only a hint, so errors (like EOPNOTSUPP) are ignored.
+  if (size_estimate > 0)
+    ::fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, size_estimate);
+
+  if (mode == mapped)
+  {
+    m_begin = m_pos = m_end = nullptr;
+    grow_mapping(std::max(size_estimate, static_cast<uint64_t>(std::max(buffer_size, max_reserve))));
+    if (m_error.empty())
+      return;
+    release();
+    THROW_ALERT("Failed to map temporary file \"[FILE]\": [ERROR]", AIArgs("[FILE]", m_temp_path.string())("[ERROR]", m_error));
+  }
+
+  m_capacity = (std::max(buffer_size, max_reserve) + alignment - 1) & ~(alignment - 1);
+  void* buffer;
+  if (posix_memalign(&buffer, alignment, m_capacity) != 0)
+  {
+    release();
+    throw std::bad_alloc();
+  }
+  m_buffer = static_cast<char*>(buffer);
+  m_begin = m_pos = m_buffer;
+  m_end = m_begin + m_capacity;
+}
+
+FileSink::~FileSink()
+{
+  if (m_fd != -1)
+    release();
+}
+
+// Unmap or free the buffer, close the file and remove it.
+void FileSink::release()
+{
+  if (m_mode == mapped)
+  {
+    if (m_buffer)
+      ::munmap(m_buffer, m_capacity);
+  }
+  else
+    std::free(m_buffer);
+  m_buffer = nullptr;
+  m_begin = m_pos = m_end = nullptr;
+  ::close(m_fd);
+  m_fd = -1;
+  ::unlink(m_temp_path.c_str());
+}
+
+void FileSink::write_buffer()
+{
+  std::size_t len = m_pos - m_begin;
+  char const* data = m_begin;
+  // Once an error occurred, the remaining output is discarded.
+  while (len > 0 && m_error.empty())
+  {
+    ssize_t written = ::write(m_fd, data, len);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      set_error(std::strerror(errno));
+      break;
+    }
+    data += written;
+    len -= written;
+  }
+  m_flushed += m_pos - m_begin;
+  m_pos = m_begin;
+}
+
+// Extend the file and its mapping to have room for at least needed more bytes.
+void FileSink::grow_mapping(std::size_t needed)
+{
+  std::size_t const used = m_pos - m_begin;
+  std::size_t capacity = std::max(m_capacity, default_file_buffer_size);
+  while (capacity < used + needed)
+    capacity *= 2;
+  capacity = (capacity + alignment - 1) & ~(alignment - 1);
+  void* map = MAP_FAILED;
+  // Allocate the disk blocks (extending the file) instead of growing a sparse file: a store into
+  // a page of the mapping that can't be backed by disk space raises SIGBUS instead of an error.
+  // posix_fallocate falls back to writing the blocks on file systems without fallocate.
+  if (int error = ::posix_fallocate(m_fd, m_capacity, capacity - m_capacity))
+    errno = error;
+  else
+    map = m_buffer ? ::mremap(m_buffer, m_capacity, capacity, MREMAP_MAYMOVE)
+                   : ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED)
+  {
+    set_error(std::strerror(errno));
+    // Keep accepting (and discarding) output until flush() reports the error.
+    if (!m_discard)
+      m_discard.reset(new char[max_reserve]);
+    m_flushed += used;
+    m_begin = m_pos = m_discard.get();
+    m_end = m_begin + max_reserve;
+    return;
+  }
+  m_buffer = static_cast<char*>(map);
+  m_capacity = capacity;
+  m_begin = m_buffer;
+  m_pos = m_begin + used;
+  m_end = m_begin + capacity;
+}
+
+void FileSink::overflow(std::size_t needed)
+{
+  if (m_mode == buffered)
+    // The buffer is at least max_reserve bytes, so emptying it always makes enough room.
+    write_buffer();
+  else if (!m_error.empty())
+  {
+    m_flushed += m_pos - m_begin;
+    m_pos = m_begin;
+  }
+  else
+    grow_mapping(needed);
+}
+
+void FileSink::sync()
+{
+  // In mapped mode the data is already in the page cache.
+  if (m_mode == buffered)
+    write_buffer();
+}
+
+void FileSink::commit()
+{
+  ASSERT(m_fd != -1);
+  uint64_t const size = bytes_written();
+  sync();
+  if (m_error.empty())
+  {
+    if (m_mode == mapped)
+    {
+      ::munmap(m_buffer, m_capacity);
+      m_buffer = nullptr;
+    }
+    // Keep the permissions of the file that is replaced; a new file gets 0666 minus the umask.
+    struct stat target;
+    bool const replaces = ::stat(m_path.c_str(), &target) == 0;
+    // Cut off the unused part of the mapping and release preallocated blocks beyond the end.
+    if ((replaces && ::fchmod(m_fd, target.st_mode & 07777) == -1) ||
+        ::ftruncate(m_fd, size) == -1 || ::fsync(m_fd) == -1 || ::rename(m_temp_path.c_str(), m_path.c_str()) == -1)
+      set_error(std::strerror(errno));
+  }
+  if (!m_error.empty())
+  {
+    release();
+    THROW_ALERT("Failed to write \"[FILE]\": [ERROR]", AIArgs("[FILE]", m_path.string())("[ERROR]", m_error));
+  }
+  ::close(m_fd);
+  m_fd = -1;
+  m_temp_path.clear();
+  if (m_mode == buffered)
+    std::free(m_buffer);
+  m_buffer = nullptr;
+  m_begin = m_pos = m_end = nullptr;
+
+  // Make the rename itself durable.
+  fs::path directory = m_path.parent_path();
+  int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd != -1)
+  {
+    ::fsync(dir_fd);
+    ::close(dir_fd);
+  }
+}
+
+} // namespace xml
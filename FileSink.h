@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class FileSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::FileSink
+ * \brief An OutputSink that atomically replaces a file.
+ *
+ * All output is written to a temporary file in the same directory as
+ * the target. Nothing is visible under the target path until commit()
+ * is called, which flushes the data to disk and renames the temporary
+ * file over the target: after a crash either the old or the new file
+ * exists, never a partially written one. If the FileSink is destroyed
+ * without calling commit() the temporary file is removed.
+ *
+ * Disk space is preallocated with `fallocate` using a size estimate
+ * (by default the size of the file that is being replaced). Output
+ * is either written through a large, page aligned buffer (buffered)
+ * or stored directly into a shared memory mapping of the file that
+ * grows as needed (mapped). In mapped mode the file is extended with
+ * `posix_fallocate`, so that running out of disk space is reported as a
+ * write error rather than raising SIGBUS. The new file gets the
+ * permissions of the file that it replaces.
+ *
+ * Writer(boost::filesystem::path const&) uses a FileSink and commits
+ * it at the end of Writer::write.
+ */
+
+#pragma once
+
+#include "OutputSink.h"
+
+#include <boost/filesystem.hpp>
+
+namespace xml {
+
+class FileSink : public OutputSink
+{
+  public:
+    static constexpr std::size_t default_file_buffer_size = 1024 * 1024;	///< The default size of the write buffer.
+    static constexpr std::size_t alignment = 4096;				///< The alignment of the write buffer.
+
+    /// The way output is transferred to the file.
+    enum mode_type
+    {
+      buffered,		///< Copy the output to the file with `write` from an aligned buffer.
+      mapped		///< Write the output directly into a growable shared memory mapping of the file.
+    };
+
+  private:
+    boost::filesystem::path m_path;		// The target path.
+    boost::filesystem::path m_temp_path;	// The temporary file that is renamed to m_path by commit().
+    int m_fd;					// File descriptor of the temporary file, or -1 after commit().
+    mode_type m_mode;
+    std::size_t m_capacity;			// The size of the buffer, or of the mapping.
+    char* m_buffer;				// The aligned buffer, or the start of the mapping.
+    std::unique_ptr<char[]> m_discard;		// Used as buffer after an error occurred in mapped mode.
+
+  public:
+    /**
+      * \brief Construct a FileSink that will replace \a path.
+      *
+      * \param path : the file to write.
+      * \param size_estimate : the expected size of the output; zero means the size of the existing file at \a path, if any.
+      * \param mode : whether to write through a buffer or a memory mapping.
+      * \param buffer_size : the size of the buffer, or the initial size of the mapping when \a size_estimate is zero.
+      *
+      * Throws AIAlert::Error when the temporary file can not be created.
+      */
+    FileSink(boost::filesystem::path const& path, uint64_t size_estimate = 0, mode_type mode = buffered, std::size_t buffer_size = default_file_buffer_size);
+
+    /// Removes the temporary file if commit() wasn't called.
+    ~FileSink() override;
+
+    /**
+      * \brief Write all data to disk and atomically replace the target file.
+      *
+      * Nothing may be written to the sink anymore afterwards.
+      * Throws AIAlert::Error if any write error occurred; the target file is left untouched in that case.
+      */
+    void commit();
+
+    /// Return true if commit() was called successfully.
+    bool committed() const { return m_fd == -1 && m_temp_path.empty(); }
+
+  protected:
+    void overflow(std::size_t needed) override;
+    void sync() override;
+
+  private:
+    void write_buffer();
+    void grow_mapping(std::size_t needed);
+    void release();
+};
+
+} // namespace xml
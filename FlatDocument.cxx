@@ -0,0 +1,310 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class FlatDocument.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "FlatDocument.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+#include <libxml/SAX2.h>
+#include <functional>
+#include <istream>
+#include <memory>
+
+namespace xml {
+
+namespace {
+
+struct ParserCtxtDeleter
+{
+  void operator()(xmlParserCtxtPtr ctxt) const
+  {
+    if (ctxt->myDoc)
+      xmlFreeDoc(ctxt->myDoc);
+    xmlFreeParserCtxt(ctxt);
+  }
+};
+
+} // namespace
+
+// Builds a FlatDocument from the SAX2 events of a push parser; stored in the _private field of the parser context.
+class FlatDocument::Builder
+{
+  private:
+    FlatDocument& m_document;
+    xmlParserCtxtPtr m_ctxt;
+    std::vector<index_type> m_open;				// The open elements.
+    std::vector<index_type> m_last_child;			// The last child element of each open element, or none.
+    index_type m_text_element;					// The element whose first text node is being appended to, or none.
+    bool m_too_large;						// Set when the document does not fit in 32-bit indices.
+    std::unordered_map<xmlChar const*, index_type> m_dict_ids;	// Map from names in the dictionary of the parser to name ids.
+
+  public:
+    Builder(FlatDocument& document) : m_document(document), m_ctxt(nullptr), m_text_element(none), m_too_large(false) { }
+
+    // Return the SAX2 handlers that build the tree, with the content callbacks replaced by the ones below.
+    static xmlSAXHandler sax_handler()
+    {
+      xmlSAXHandler sax;
+      xmlSAXVersion(&sax, 2);
+      sax.startElementNs = &start_element;
+      sax.endElementNs = &end_element;
+      sax.characters = &characters;
+      sax.ignorableWhitespace = &characters;
+      sax.cdataBlock = &other_node;
+      sax.comment = &comment;
+      sax.processingInstruction = &processing_instruction;
+      sax.serror = &ignore_error;
+      return sax;
+    }
+
+    // Replace the contents of document with the document that is returned in chunks by next_chunk, until it returns an empty chunk.
+    static void parse(FlatDocument& document, std::function<std::string_view()> const& next_chunk);
+
+  private:
+    static Builder& from(void* ctx) { return *static_cast<Builder*>(static_cast<xmlParserCtxtPtr>(ctx)->_private); }
+
+    // Return false, and stop the parser, if size does not fit in index_type. Exceptions can't be thrown through the parser.
+    bool fits(std::size_t size)
+    {
+      if (size < none)
+        return true;
+      m_too_large = true;
+      xmlStopParser(m_ctxt);
+      return false;
+    }
+
+    index_type name_id(xmlChar const* name)
+    {
+      auto id = m_dict_ids.find(name);
+      if (id != m_dict_ids.end())
+        return id->second;
+      std::string_view const str(reinterpret_cast<char const*>(name));
+      auto name_id = m_document.m_name_ids.find(str);
+      if (name_id == m_document.m_name_ids.end())
+      {
+        m_document.m_names.emplace_back(str);
+        name_id = m_document.m_name_ids.emplace(m_document.m_names.back(), m_document.m_names.size() - 1).first;
+      }
+      m_dict_ids.emplace(name, name_id->second);
+      return name_id->second;
+    }
+
+    index_type append(xmlChar const* str, std::size_t len)
+    {
+      index_type const offset = m_document.m_arena.size();
+      m_document.m_arena.append(reinterpret_cast<char const*>(str), len);
+      return offset;
+    }
+
+    // Any node other than text ends the text node that is being appended to.
+    void end_text()
+    {
+      m_text_element = none;
+    }
+
+    static void start_element(void* ctx, xmlChar const* localname, xmlChar const* UNUSED_ARG(prefix), xmlChar const* UNUSED_ARG(URI),
+        int UNUSED_ARG(nb_namespaces), xmlChar const** UNUSED_ARG(namespaces), int nb_attributes, int UNUSED_ARG(nb_defaulted), xmlChar const** attributes)
+    {
+      Builder& builder = from(ctx);
+      FlatDocument& document = builder.m_document;
+      std::size_t attributes_size = 0;
+      for (int i = 0; i < nb_attributes; ++i)
+        attributes_size += attributes[5 * i + 4] - attributes[5 * i + 3];
+      if (!builder.fits(document.m_elements.size()) || !builder.fits(document.m_attributes.size() + nb_attributes) ||
+          !builder.fits(document.m_arena.size() + attributes_size))
+        return;
+      index_type const index = document.m_elements.size();
+      index_type const parent = builder.m_open.empty() ? none : builder.m_open.back();
+      if (parent != none)
+      {
+        Element& parent_element = document.m_elements[parent];
+        index_type& last_child = builder.m_last_child.back();
+        if (last_child == none)
+          parent_element.m_first_child = index;
+        else
+          document.m_elements[last_child].m_next_sibling = index;
+        last_child = index;
+      }
+      builder.end_text();
+      Element element;
+      element.m_name = builder.name_id(localname);
+      element.m_parent = parent;
+      element.m_first_child = none;
+      element.m_next_sibling = none;
+      element.m_first_attribute = document.m_attributes.size();
+      element.m_attributes = nb_attributes;
+      element.m_text = none;
+      element.m_text_length = 0;
+      element.m_line = builder.m_ctxt->input->line;
+      // Every attribute is passed as localname, prefix, URI, value and end of value.
+      for (int i = 0; i < nb_attributes; ++i, attributes += 5)
+      {
+        Attribute attribute;
+        attribute.m_name = builder.name_id(attributes[0]);
+        attribute.m_value_length = attributes[4] - attributes[3];
+        attribute.m_value = builder.append(attributes[3], attribute.m_value_length);
+        document.m_attributes.push_back(attribute);
+      }
+      document.m_elements.push_back(element);
+      builder.m_open.push_back(index);
+      builder.m_last_child.push_back(none);
+    }
+
+    static void end_element(void* ctx, xmlChar const* UNUSED_ARG(localname), xmlChar const* UNUSED_ARG(prefix), xmlChar const* UNUSED_ARG(URI))
+    {
+      Builder& builder = from(ctx);
+      builder.end_text();
+      builder.m_open.pop_back();
+      builder.m_last_child.pop_back();
+    }
+
+    static void characters(void* ctx, xmlChar const* ch, int len)
+    {
+      Builder& builder = from(ctx);
+      if (builder.m_open.empty() || !builder.fits(builder.m_document.m_arena.size() + len))
+        return;
+      index_type const index = builder.m_open.back();
+      Element& element = builder.m_document.m_elements[index];
+      if (builder.m_text_element == index)
+      {
+        builder.append(ch, len);
+        element.m_text_length += len;
+      }
+      else if (element.m_text == none)
+      {
+        element.m_text = builder.append(ch, len);
+        element.m_text_length = len;
+        builder.m_text_element = index;
+      }
+    }
+
+    static void other_node(void* ctx, xmlChar const* UNUSED_ARG(value), int UNUSED_ARG(len))
+    {
+      from(ctx).end_text();
+    }
+
+    static void comment(void* ctx, xmlChar const* UNUSED_ARG(value))
+    {
+      from(ctx).end_text();
+    }
+
+    static void processing_instruction(void* ctx, xmlChar const* UNUSED_ARG(target), xmlChar const* UNUSED_ARG(data))
+    {
+      from(ctx).end_text();
+    }
+
+    // Errors are reported by the exception that FlatDocument::parse throws, not on stderr.
+    // A template, because the constness of the error parameter differs between libxml2 versions.
+    template<typename ERROR>
+    static void ignore_error(void*, ERROR)
+    {
+    }
+};
+
+void FlatDocument::Builder::parse(FlatDocument& document, std::function<std::string_view()> const& next_chunk)
+{
+  document.m_elements.clear();
+  document.m_attributes.clear();
+  document.m_arena.clear();
+  document.m_name_ids.clear();
+  document.m_names.clear();
+  Builder builder(document);
+  xmlSAXHandler sax = sax_handler();
+  std::unique_ptr<xmlParserCtxt, ParserCtxtDeleter> ctxt(xmlCreatePushParserCtxt(&sax, nullptr, nullptr, 0, nullptr));
+  if (!ctxt)
+  {
+    THROW_ALERT("Failed to parse XML: could not create parser context.");
+  }
+  xmlCtxtUseOptions(ctxt.get(), XML_PARSE_NOENT);
+  ctxt->_private = &builder;
+  builder.m_ctxt = ctxt.get();
+  for (std::string_view chunk = next_chunk(); !chunk.empty(); chunk = next_chunk())
+    if (xmlParseChunk(ctxt.get(), chunk.data(), chunk.size(), 0) != 0)
+      break;
+  xmlParseChunk(ctxt.get(), nullptr, 0, 1);
+  if (builder.m_too_large)
+  {
+    document.m_elements.clear();
+    THROW_ALERT("Failed to parse XML: the document is too large for a FlatDocument.");
+  }
+  if (!ctxt->wellFormed || document.m_elements.empty())
+  {
+    xmlError const* error = xmlCtxtGetLastError(ctxt.get());
+    document.m_elements.clear();
+    THROW_ALERT("Failed to parse XML: [WHAT]", AIArgs("[WHAT]", error && error->message ? error->message : "unknown error."));
+  }
+  document.m_elements.shrink_to_fit();
+  document.m_attributes.shrink_to_fit();
+  document.m_arena.shrink_to_fit();
+  Dout(dc::xmlparser, "Parsed a FlatDocument of " << document.m_elements.size() << " elements and " << document.memory_size() << " bytes.");
+}
+
+void FlatDocument::parse(std::istream& input)
+{
+  char buffer[65536];
+  Builder::parse(*this, [&]{
+    input.read(buffer, sizeof(buffer));
+    return std::string_view(buffer, input.gcount());
+  });
+}
+
+void FlatDocument::parse(std::string_view document)
+{
+  // Feed the document in chunks: the parser refuses chunks of more than 10 MB without XML_PARSE_HUGE.
+  std::size_t const max_chunk = 1024 * 1024;
+  Builder::parse(*this, [&]{
+    std::string_view chunk = document.substr(0, max_chunk);
+    document.remove_prefix(chunk.size());
+    return chunk;
+  });
+}
+
+FlatDocument::Attribute const* FlatDocument::find_attribute(Element const& element, index_type name) const
+{
+  for (index_type i = element.m_first_attribute; i < element.m_first_attribute + element.m_attributes; ++i)
+    if (m_attributes[i].m_name == name)
+      return &m_attributes[i];
+  return nullptr;
+}
+
+std::size_t FlatDocument::child_count(Element const& element) const
+{
+  std::size_t count = 0;
+  for (index_type child = element.m_first_child; child != none; child = m_elements[child].m_next_sibling)
+    ++count;
+  return count;
+}
+
+std::size_t FlatDocument::memory_size() const
+{
+  std::size_t size = m_elements.capacity() * sizeof(Element) + m_attributes.capacity() * sizeof(Attribute) + m_arena.capacity();
+  // Roughly: the strings of the names, and a node and a bucket per entry of m_name_ids.
+  for (std::string const& name : m_names)
+    size += sizeof(std::string) + name.capacity() + 1;
+  size += m_name_ids.size() * (sizeof(std::string_view) + sizeof(index_type) + 4 * sizeof(void*));
+  return size;
+}
+
+} // namespace xml
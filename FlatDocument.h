@@ -0,0 +1,148 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class FlatDocument.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::FlatDocument
+ * \brief A compact, read-only representation of a parsed XML document.
+ *
+ * A libxml2 tree costs more than a hundred bytes per node, plus a libxml++
+ * wrapper per node that is visited, and the whitespace between elements
+ * adds a text node for nearly every element. A FlatDocument is built
+ * directly from SAX events and stores only what FlatReader needs:
+ *   - the elements in one array in document order, linked by 32-bit indices;
+ *   - the element and attribute names as ids into a table of interned names;
+ *   - the attributes of each element as a contiguous range of one array;
+ *   - the attribute values and the first text node of each element as
+ *     offset and length into one string arena.
+ *
+ * Comments, processing instructions and CDATA sections are not stored.
+ * Text of an element after its first text node is dropped, just like
+ * ReadBridge only reads the first text node; that first text node is kept
+ * even when it is only the indentation of a child element, so that
+ * FlatReader reads the same values as Reader.
+ *
+ * See FlatReader.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xml {
+
+class FlatDocument
+{
+  public:
+    using index_type = uint32_t;
+    static constexpr index_type none = ~index_type{0};	///< The index of an absent element or name.
+
+    struct Element
+    {
+      index_type m_name;		///< The id of the name of the element.
+      index_type m_parent;		///< The index of the parent element, or none for the root element.
+      index_type m_first_child;		///< The index of the first child element, or none.
+      index_type m_next_sibling;	///< The index of the next sibling element, or none.
+      index_type m_first_attribute;	///< The index of the first attribute of this element.
+      index_type m_attributes;		///< The number of attributes.
+      index_type m_text;		///< The offset of the first text node in the arena, or none when there is no text node.
+      index_type m_text_length;		///< The length of the first text node.
+      index_type m_line;		///< The line number of the start tag.
+    };
+
+    struct Attribute
+    {
+      index_type m_name;		///< The id of the name of the attribute.
+      index_type m_value;		///< The offset of the value in the arena.
+      index_type m_value_length;	///< The length of the value.
+    };
+
+  private:
+    std::vector<Element> m_elements;					// All elements, in document order; the root element is at index 0.
+    std::vector<Attribute> m_attributes;				// All attributes, grouped per element.
+    std::string m_arena;						// All attribute values and text.
+    std::deque<std::string> m_names;					// The interned names, by id (a deque, so that m_name_ids can refer to them).
+    std::unordered_map<std::string_view, index_type> m_name_ids;	// Map from name to id.
+
+  public:
+    /// Construct an empty FlatDocument.
+    FlatDocument() = default;
+
+    // Not copyable: the keys of m_name_ids point into m_names. Moving keeps the strings in place.
+    FlatDocument(FlatDocument const&) = delete;
+    FlatDocument& operator=(FlatDocument const&) = delete;
+    FlatDocument(FlatDocument&&) = default;
+    FlatDocument& operator=(FlatDocument&&) = default;
+
+    /// Parse the XML document from \a input, replacing the current contents. Throws AIAlert::Error when the document is not well-formed.
+    void parse(std::istream& input);
+
+    /// Parse the XML document \a document, replacing the current contents.
+    void parse(std::string_view document);
+
+    /// Return true if no document was parsed.
+    bool empty() const { return m_elements.empty(); }
+
+    /// Return the element at \a index.
+    Element const& element(index_type index) const { return m_elements[index]; }
+
+    /// Return the number of elements.
+    std::size_t elements() const { return m_elements.size(); }
+
+    /// Return the name with id \a name.
+    std::string_view name(index_type name) const { return m_names[name]; }
+
+    /// Return the id of \a name, or none if no element or attribute in the document has that name.
+    index_type find_name(std::string_view name) const
+    {
+      auto id = m_name_ids.find(name);
+      return id == m_name_ids.end() ? none : id->second;
+    }
+
+    /// Return the first text node of \a element (empty when there is none).
+    std::string_view text(Element const& element) const
+    {
+      return element.m_text == none ? std::string_view() : std::string_view(m_arena.data() + element.m_text, element.m_text_length);
+    }
+
+    /// Return the attribute of \a element with name id \a name, or null if it doesn't have one.
+    Attribute const* find_attribute(Element const& element, index_type name) const;
+
+    /// Return the value of \a attribute.
+    std::string_view value(Attribute const& attribute) const { return std::string_view(m_arena.data() + attribute.m_value, attribute.m_value_length); }
+
+    /// Return the number of child elements of \a element.
+    std::size_t child_count(Element const& element) const;
+
+    /// Return the number of bytes allocated for the document.
+    std::size_t memory_size() const;
+
+  private:
+    class Builder;
+};
+
+} // namespace xml
@@ -0,0 +1,259 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class FlatReader.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "FlatReader.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+
+namespace fs = boost::filesystem;
+
+namespace xml {
+
+void FlatReader::parse(std::istream& file, uint32_t version_major)
+{
+  set_version(version_major);
+  {
+    Tracer::Scope trace("FlatReader::parse");
+    MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+    m_document.parse(file);
+  }
+  reset_state();
+}
+
+void FlatReader::parse_memory(std::string_view document, uint32_t version_major)
+{
+  set_version(version_major);
+  {
+    Tracer::Scope trace("FlatReader::parse");
+    MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+    m_document.parse(document);
+  }
+  reset_state();
+}
+
+void FlatReader::parse(fs::path const& filepath, uint32_t version_major)
+{
+  std::ifstream file;
+  open_file(file, filepath);
+  parse(file, version_major);
+  file.close();
+}
+
+void FlatReader::reset_state()
+{
+  m_state = state_type();
+  m_state_stack = {};
+  Bridge::m_state_stack = {};
+  Bridge::m_state.m_depth = 0;
+}
+
+FlatReader::index_type FlatReader::find_sibling(index_type element, index_type name) const
+{
+  while (element != FlatDocument::none && m_document.element(element).m_name != name)
+    element = m_document.element(element).m_next_sibling;
+  return element;
+}
+
+void FlatReader::refresh_children(index_type parent, index_type name)
+{
+  m_state.m_current_parent = parent;
+  m_state.m_current_child_name = name;
+  m_state.m_current_child = find_sibling(m_document.element(parent).m_first_child, name);
+}
+
+FlatReader::index_type FlatReader::requested_parent() const
+{
+  index_type const parent = m_state.m_current_parent;
+  return parent != FlatDocument::none && m_document.element(m_state.m_element).m_parent == parent ? parent : m_state.m_element;
+}
+
+std::string_view FlatReader::child_name() const
+{
+  return m_state.m_current_child_name == FlatDocument::none ? std::string_view() : m_document.name(m_state.m_current_child_name);
+}
+
+void FlatReader::select_element(std::string_view name)
+{
+  profile_element(name);
+  if (m_state.m_current_child == FlatDocument::none)
+  {
+    if (m_profiler)
+      m_profiler->no_child_left(name);
+    FlatDocument::Element const& parent = m_document.element(m_state.m_current_parent);
+    THROW_ALERT_CLASS(NoChildLeft, "While processing children of element <[PARENT]> (line [LINE]): no child with name <[NAME]> (left)!",
+        AIArgs("[PARENT]", std::string(m_document.name(parent.m_name)))("[LINE]", parent.m_line)("[NAME]", std::string(name)));
+  }
+  m_state.m_element = m_state.m_current_child;
+  Dout(dc::xmlparser, "Starting element <" << name << "> line " << m_document.element(m_state.m_element).m_line << ".");
+}
+
+void FlatReader::node_name(char const* name)
+{
+  if (m_state.m_element == FlatDocument::none)
+  {
+    // If this fails then you didn't parse a document. Call FlatReader::parse().
+    ASSERT(!m_document.empty());
+
+    profile_element(name);
+    m_state.m_element = 0;
+    std::string_view const root_name = m_document.name(m_document.element(0).m_name);
+    if (root_name != name)
+    {
+      THROW_ALERT("Root node has name <[ROOTNAME]>, expected <[NAME]>.",
+          AIArgs("[ROOTNAME]", std::string(root_name))("[NAME]", name));
+    }
+    Dout(dc::xmlparser, "Found root node <" << root_name << ">.");
+    return;
+  }
+  index_type const name_id = m_document.find_name(name);
+  if (m_document.element(m_state.m_element).m_parent != m_state.m_current_parent || m_state.m_current_child_name != name_id)
+    refresh_children(requested_parent(), name_id);	// A different name requested after reading a child looks for siblings of that child.
+  else if (m_state.m_current_child != FlatDocument::none)
+    m_state.m_current_child = find_sibling(m_document.element(m_state.m_current_child).m_next_sibling, name_id);
+  select_element(name);
+}
+
+void FlatReader::attribute(char const* name, char const* value)
+{
+  FlatDocument::Element const& element = m_document.element(m_state.m_element);
+  FlatDocument::Attribute const* attribute = m_document.find_attribute(element, m_document.find_name(name));
+  if (!attribute)
+  {
+    THROW_ALERT("Element <[ELEMENTNAME]> at line [LINE] does not have attribute '[NAME]'.",
+        AIArgs("[ELEMENTNAME]", std::string(m_document.name(element.m_name)))("[LINE]", element.m_line)("[NAME]", name));
+  }
+  if (m_document.value(*attribute) != value)
+  {
+    THROW_ALERT("Wrong attribute '[NAME]' in node <[ELEMENTNAME]> (line [LINE]); value is \"[VALUE]\", expected \"[EXPECTED]\".",
+        AIArgs("[NAME]", name)("[ELEMENTNAME]", std::string(m_document.name(element.m_name)))("[LINE]", element.m_line)
+          ("[VALUE]", std::string(m_document.value(*attribute)))("[EXPECTED]", value));
+  }
+}
+
+void FlatReader::child(char const* name, char const* value)
+{
+  open_child(name);
+  if (value != read_child_stream())
+  {
+    FlatDocument::Element const& element = m_document.element(m_state.m_current_child);
+    THROW_ALERT("Element <[NAME]> (line [LINE]) has value \"[VALUE]\", expected \"[EXPECTED]\".",
+        AIArgs("[NAME]", name)("[LINE]", element.m_line)("[VALUE]", std::string(read_child_stream()))("[EXPECTED]", value));
+  }
+  close_child();
+}
+
+void FlatReader::open_child()
+{
+  DoutEntering(dc::xmlparser, "FlatReader::open_child()");
+
+  Bridge::push_state();
+  m_state_stack.push(m_state);
+  m_state = state_type(m_state.m_element);
+  Debug(libcw_do.push_marker());
+  Debug(libcw_do.marker().append("| "));
+}
+
+void FlatReader::open_child(char const* name)
+{
+  DoutEntering(dc::xmlparser, "FlatReader::open_child(\"" << name << "\")");
+
+  open_child();
+  refresh_children(m_state.m_element, m_document.find_name(name));
+  select_element(name);
+}
+
+void FlatReader::close_child()
+{
+  Debug(libcw_do.pop_marker());
+  Dout(dc::xmlparser, "FlatReader::close_child() </" << child_name() << ">");
+  m_state = m_state_stack.top();
+  m_state_stack.pop();
+  Bridge::pop_state();
+}
+
+void FlatReader::get_element()
+{
+  select_element(child_name());
+}
+
+void FlatReader::next_child()
+{
+  // Call get_element() (open_child(name) or next_child()) before calling next_child().
+  ASSERT(m_state.m_current_child != FlatDocument::none);
+  m_state.m_current_child = find_sibling(m_document.element(m_state.m_current_child).m_next_sibling, m_state.m_current_child_name);
+  select_element(child_name());
+}
+
+bool FlatReader::read_attribute(char const* name, std::string_view& attribute_str, bool mandatory) const
+{
+  FlatDocument::Element const& element = m_document.element(m_state.m_element);
+  FlatDocument::Attribute const* attribute = m_document.find_attribute(element, m_document.find_name(name));
+  if (!attribute)
+  {
+    if (mandatory)
+    {
+      THROW_ALERT("Element <[ELEMENTNAME]> at line [LINE] does not have attribute '[NAME]'.",
+          AIArgs("[ELEMENTNAME]", std::string(m_document.name(element.m_name)))("[LINE]", element.m_line)("[NAME]", name));
+    }
+    return false;
+  }
+  attribute_str = m_document.value(*attribute);
+  Dout(dc::xmlparser, "Read attribute '" << name << "=\"" << attribute_str << "\"'.");
+  return true;
+}
+
+std::string_view FlatReader::read_child_stream()
+{
+  // Call get_element() (open_child(name) or next_child()) before calling read_child_stream.
+  ASSERT(m_state.m_current_child != FlatDocument::none);
+  return m_document.text(m_document.element(m_state.m_current_child));
+}
+
+std::size_t FlatReader::children_count_hint() const
+{
+  // After open_child(name) count the remaining children with that name.
+  if (m_state.m_current_child != FlatDocument::none)
+  {
+    std::size_t count = 0;
+    for (index_type child = m_state.m_current_child; child != FlatDocument::none;
+        child = find_sibling(m_document.element(child).m_next_sibling, m_state.m_current_child_name))
+      ++count;
+    return count;
+  }
+  if (m_state.m_element == FlatDocument::none)
+    return 0;
+  // Otherwise the name is not known yet: only count the child elements when they all have the same name.
+  std::size_t count = 0;
+  index_type name = FlatDocument::none;
+  for (index_type child = m_document.element(m_state.m_element).m_first_child; child != FlatDocument::none; child = m_document.element(child).m_next_sibling)
+  {
+    if (name != FlatDocument::none && m_document.element(child).m_name != name)
+      return 0;
+    name = m_document.element(child).m_name;
+    ++count;
+  }
+  return count;
+}
+
+} // namespace xml
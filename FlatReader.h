@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class FlatReader.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::FlatReader
+ * \brief Reads objects from a FlatDocument; a Reader with a smaller memory footprint.
+ *
+ * A FlatReader parses the document into a FlatDocument instead of a libxml2
+ * tree and implements the reading side of Bridge on top of it, with the same
+ * semantics as ReadBridge. Because the elements are stored in document order,
+ * reading visits them mostly sequentially in memory.
+ *
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::FlatReader reader;
+ * reader.parse(path, 1);
+ * Catalog catalog;
+ * reader.read(catalog);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+
+#pragma once
+
+#include "Bridge.h"
+#include "FlatDocument.h"
+
+#include <cinttypes>
+#include <iosfwd>
+#include <stack>
+#include <string_view>
+#include <boost/filesystem.hpp>
+
+namespace xml {
+
+class FlatReader : public Bridge
+{
+  public:
+    using index_type = FlatDocument::index_type;
+
+    /// The type of m_state; see ReadBridge::state_type.
+    struct state_type {
+      index_type m_current_parent;		///< The parent element of the children with name m_current_child_name.
+      index_type m_current_child_name;		///< The name id of the children that are being read.
+      index_type m_current_child;		///< The current child with that name, or none at the end.
+      index_type m_element;			///< The current (child) element being processed, or none before the root element.
+
+      /// Construct a state_type for element \a element with no children selected yet.
+      state_type(index_type element = FlatDocument::none) :
+        m_current_parent(FlatDocument::none), m_current_child_name(FlatDocument::none), m_current_child(FlatDocument::none), m_element(element) { }
+    };
+
+  private:
+    FlatDocument m_document;			// The parsed document.
+    state_type m_state;				// State information.
+    std::stack<state_type> m_state_stack;	// Stored state information of parent elements.
+
+  public:
+    /// Construct an empty FlatReader.
+    FlatReader() : Bridge(0) { }
+
+    /// Parse an XML file.
+    void parse(std::istream& file, uint32_t version_major);
+
+    /// Parse an XML file.
+    void parse(boost::filesystem::path const& file, uint32_t version_major);
+
+    /// Parse the XML document \a document.
+    void parse_memory(std::string_view document, uint32_t version_major);
+
+    /// Return the parsed document.
+    FlatDocument const& document() const { return m_document; }
+
+    /// Read \a object from the parsed XML document; see Reader::read.
+    template<typename T>
+      void read(T& object);
+
+  protected:
+    /*virtual*/ bool writing() const { return false; }
+    /*virtual*/ void node_name(char const* name);
+    /*virtual*/ void attribute(char const* name, char const* value);
+    /*virtual*/ void child(const char*, const char*);
+
+/// @cond Doxygen_Suppress
+  protected:
+    /*virtual*/ void open_child();
+    /*virtual*/ void open_child(char const* name);
+    /*virtual*/ void close_child();
+    /*virtual*/ void get_element();
+    /*virtual*/ void next_child();
+    /*virtual*/ bool read_attribute(char const* name, std::string_view& attribute_str, bool mandatory) const;
+    /*virtual*/ std::string_view read_child_stream();
+    /*virtual*/ std::size_t children_count_hint() const;
+/// @endcond
+
+  private:
+    // Start reading at the root element again; called after parsing a new document.
+    void reset_state();
+    // Select the children of parent with name id name.
+    void refresh_children(index_type parent, index_type name);
+    // Return the element whose children node_name looks for: m_state.m_current_parent while m_state.m_element is one of its children, otherwise m_state.m_element.
+    index_type requested_parent() const;
+    // Return the first sibling of element, starting at element itself, with name id name, or none.
+    index_type find_sibling(index_type element, index_type name) const;
+    // Return the name of the children that are being read.
+    std::string_view child_name() const;
+    // Set m_state.m_element to m_state.m_current_child, throwing NoChildLeft (for name) if that is none.
+    void select_element(std::string_view name);
+};
+
+template<typename T>
+void FlatReader::read(T& object)
+{
+  Tracer::Scope trace("FlatReader::read");
+  MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::deserialize);
+  Profiler::Scope profile(m_profiler, true);
+  object.xml(*this);
+}
+
+} // namespace xml
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief This file contains the declaration of struct Format.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::Format
+ * \brief Formatting policy of a Writer.
+ *
+ * By default every element is written on its own line, indented by
+ * two spaces per level. Use one of the static factory functions to
+ * get compact output (no whitespace at all), indentation of a different
+ * width or with tabs, or pretty printing only up to a given depth:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Writer writer(os, xml::Format::compact());
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+
+#pragma once
+
+#include <climits>
+
+namespace xml {
+
+struct Format
+{
+  int m_indentation;		///< The number of indentation characters per level.
+  char m_indent_char;		///< The character used for indentation (' ' or '\t').
+  int m_pretty_depth;		///< Elements at a depth less than this (the root element has depth 0) start on a new line; deeper elements are written without whitespace.
+
+  /// Construct the default format: two spaces per level, at any depth.
+  Format() : m_indentation(2), m_indent_char(' '), m_pretty_depth(INT_MAX) { }
+
+  /// Construct a format with \a indentation times \a indent_char per level, up till depth \a pretty_depth.
+  Format(int indentation, char indent_char, int pretty_depth) :
+    m_indentation(indentation), m_indent_char(indent_char), m_pretty_depth(pretty_depth) { }
+
+  /// No whitespace between elements at all.
+  static Format compact() { return { 0, ' ', 0 }; }
+
+  /// Every element on its own line, indented with \a indentation spaces per level.
+  static Format pretty(int indentation = 2) { return { indentation, ' ', INT_MAX }; }
+
+  /// Every element on its own line, indented with one tab per level.
+  static Format tabs() { return { 1, '\t', INT_MAX }; }
+
+  /// Only elements at a depth less than \a depth on their own line, indented with \a indentation spaces per level.
+  static Format pretty_up_to(int depth, int indentation = 2) { return { indentation, ' ', depth }; }
+};
+
+} // namespace xml
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class MarkupScanner.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "MarkupScanner.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace xml {
+
+namespace {
+
+// Return the position of the '>' that closes the markup at the start of str, skipping quoted strings
+// and, if internal_subset is set, a DOCTYPE internal subset between square brackets. Returns npos if not found.
+std::size_t markup_end(std::string_view str, bool internal_subset)
+{
+  char quote = 0;
+  int brackets = 0;
+  for (std::size_t i = 1; i < str.size(); ++i)
+  {
+    char c = str[i];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+    }
+    else if (c == '"' || c == '\'')
+      quote = c;
+    else if (internal_subset && c == '[')
+      ++brackets;
+    else if (internal_subset && c == ']')
+      --brackets;
+    else if (c == '>' && brackets == 0)
+      return i;
+  }
+  return std::string_view::npos;
+}
+
+bool is_space(char c)
+{
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// Append the UTF-8 encoding of code point cp to out.
+void append_utf8(std::string& out, unsigned long cp)
+{
+  if (cp < 0x80)
+    out += static_cast<char>(cp);
+  else if (cp < 0x800)
+  {
+    out += static_cast<char>(0xc0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  }
+  else if (cp < 0x10000)
+  {
+    out += static_cast<char>(0xe0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  }
+  else
+  {
+    out += static_cast<char>(0xf0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  }
+}
+
+// Return raw with the predefined entities and character references replaced; unknown references are copied as is.
+std::string unescape(std::string_view raw)
+{
+  static struct { char const* m_name; char m_c; } const entities[] = {
+    { "lt;", '<' }, { "gt;", '>' }, { "amp;", '&' }, { "quot;", '"' }, { "apos;", '\'' }
+  };
+  std::string out;
+  out.reserve(raw.size());
+  std::size_t pos = 0;
+  std::size_t amp;
+  while ((amp = raw.find('&', pos)) != std::string_view::npos)
+  {
+    out.append(raw.substr(pos, amp - pos));
+    std::string_view ref = raw.substr(amp + 1);
+    std::size_t semicolon = ref.find(';');
+    pos = amp + 1;
+    if (semicolon == std::string_view::npos)
+    {
+      out += '&';
+      continue;
+    }
+    if (ref[0] == '#')
+    {
+      bool const hex = ref.size() > 1 && ref[1] == 'x';
+      std::string digits(ref.substr(hex ? 2 : 1, semicolon - (hex ? 2 : 1)));
+      char* end;
+      unsigned long cp = std::strtoul(digits.c_str(), &end, hex ? 16 : 10);
+      if (!digits.empty() && *end == 0)
+      {
+        append_utf8(out, cp);
+        pos = amp + 2 + semicolon;
+        continue;
+      }
+    }
+    else
+    {
+      bool found = false;
+      for (auto const& entity : entities)
+        if (ref.compare(0, std::strlen(entity.m_name), entity.m_name) == 0)
+        {
+          out += entity.m_c;
+          pos = amp + 1 + std::strlen(entity.m_name);
+          found = true;
+          break;
+        }
+      if (found)
+        continue;
+    }
+    out += '&';
+  }
+  out.append(raw.substr(pos));
+  return out;
+}
+
+} // namespace
+
+MarkupScanner::Token MarkupScanner::next(std::string_view str, bool eof)
+{
+  if (str.empty())
+    return { incomplete, 0 };
+  if (str[0] != '<')
+  {
+    void const* lt = std::memchr(str.data(), '<', str.size());
+    return { text, lt ? static_cast<std::size_t>(static_cast<char const*>(lt) - str.data()) : str.size() };
+  }
+  // Wait for enough input to recognize the kind of markup.
+  if (str.size() < 9 && !eof)
+    return { incomplete, 0 };
+  if (str.compare(0, 2, "<?") == 0)
+  {
+    std::size_t end = str.find("?>", 2);
+    return end == std::string_view::npos ? Token{ incomplete, 0 } : Token{ other, end + 2 };
+  }
+  if (str.compare(0, 4, "<!--") == 0)
+  {
+    std::size_t end = str.find("-->", 4);
+    return end == std::string_view::npos ? Token{ incomplete, 0 } : Token{ other, end + 3 };
+  }
+  if (str.compare(0, 9, "<![CDATA[") == 0)
+  {
+    std::size_t end = str.find("]]>", 9);
+    return end == std::string_view::npos ? Token{ incomplete, 0 } : Token{ other, end + 3 };
+  }
+  bool const declaration = str[1] == '!';
+  std::size_t end = markup_end(str, declaration);
+  if (end == std::string_view::npos)
+    return { incomplete, 0 };
+  if (declaration)
+    return { other, end + 1 };
+  if (str[1] == '/')
+    return { end_tag, end + 1 };
+  return { str[end - 1] == '/' ? empty_element_tag : start_tag, end + 1 };
+}
+
+std::string_view MarkupScanner::tag_name(std::string_view tag)
+{
+  std::size_t begin = tag.size() > 1 && tag[1] == '/' ? 2 : 1;
+  std::size_t end = begin;
+  while (end < tag.size() && !is_space(tag[end]) && tag[end] != '>' && tag[end] != '/')
+    ++end;
+  return tag.substr(begin, end - begin);
+}
+
+bool MarkupScanner::attribute_value(std::string_view tag, std::string_view name, std::string& value)
+{
+  std::size_t pos = 1 + tag_name(tag).size();
+  for (;;)
+  {
+    while (pos < tag.size() && is_space(tag[pos]))
+      ++pos;
+    std::size_t name_end = tag.find('=', pos);
+    if (name_end == std::string_view::npos)
+      return false;
+    std::string_view attribute_name = tag.substr(pos, name_end - pos);
+    while (!attribute_name.empty() && is_space(attribute_name.back()))
+      attribute_name.remove_suffix(1);
+    pos = tag.find_first_of("\"'", name_end + 1);
+    if (pos == std::string_view::npos)
+      return false;
+    std::size_t value_end = tag.find(tag[pos], pos + 1);
+    if (value_end == std::string_view::npos)
+      return false;
+    if (attribute_name == name)
+    {
+      value = unescape(tag.substr(pos + 1, value_end - pos - 1));
+      return true;
+    }
+    pos = value_end + 1;
+  }
+}
+
+} // namespace xml
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class MarkupScanner.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::MarkupScanner
+ * \brief Splits raw XML text into character data and markup without parsing it.
+ *
+ * This is not a parser: it only recognizes where each tag, comment,
+ * processing instruction, CDATA section or declaration ends, so that the
+ * boundaries of elements can be found in a byte stream cheaply.
+ * Used by RecordReader and RecordIndex.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace xml {
+
+class MarkupScanner
+{
+  public:
+    enum token_type
+    {
+      incomplete,		///< More input is needed to determine the end of the token.
+      text,			///< Character data.
+      start_tag,		///< A start tag, `<name ...>`.
+      end_tag,			///< An end tag, `</name>`.
+      empty_element_tag,	///< An empty-element tag, `<name ... />`.
+      other			///< A comment, processing instruction, CDATA section or declaration.
+    };
+
+    /// The result of next().
+    struct Token
+    {
+      token_type m_type;	///< The kind of token.
+      std::size_t m_length;	///< The number of bytes of the token; zero when m_type is incomplete.
+    };
+
+    /**
+      * \brief Return the kind and the length of the token at the start of \a str.
+      *
+      * \param str : the input, starting with character data or a '<'.
+      * \param eof : true if no input follows \a str; otherwise markup that does not fit in \a str is reported as incomplete.
+      */
+    static Token next(std::string_view str, bool eof);
+
+    /// Return the element name of the start, end or empty-element tag \a tag.
+    static std::string_view tag_name(std::string_view tag);
+
+    /**
+      * \brief Look up attribute \a name in start or empty-element tag \a tag.
+      *
+      * If found, \a value is set to its value with predefined entities and character references replaced.
+      *
+      * \returns True if the attribute was found.
+      */
+    static bool attribute_value(std::string_view tag, std::string_view name, std::string& value);
+};
+
+} // namespace xml
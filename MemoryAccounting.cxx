@@ -0,0 +1,160 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class MemoryAccounting.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "MemoryAccounting.h"
+#include "debug.h"
+#include <libxml/xmlmemory.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <malloc.h>
+
+namespace xml {
+
+namespace {
+
+// Allocation counters of libxml2, per thread.
+struct ThreadCounters
+{
+  uint64_t m_allocations;
+  uint64_t m_allocated_bytes;
+  int64_t m_live_bytes;
+  int64_t m_peak_live_bytes;
+};
+
+thread_local ThreadCounters t_counters;
+
+void count_allocation(void* ptr)
+{
+  if (!ptr)
+    return;
+  std::size_t size = malloc_usable_size(ptr);
+  ++t_counters.m_allocations;
+  t_counters.m_allocated_bytes += size;
+  t_counters.m_live_bytes += size;
+  if (t_counters.m_live_bytes > t_counters.m_peak_live_bytes)
+    t_counters.m_peak_live_bytes = t_counters.m_live_bytes;
+}
+
+// Because the sizes are obtained with malloc_usable_size, memory that was
+// allocated before install() was called can be freed through these functions too.
+
+void* counting_malloc(std::size_t size)
+{
+  void* ptr = std::malloc(size);
+  count_allocation(ptr);
+  return ptr;
+}
+
+void* counting_realloc(void* ptr, std::size_t size)
+{
+  std::size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+  void* new_ptr = std::realloc(ptr, size);
+  if (new_ptr)
+  {
+    t_counters.m_live_bytes -= old_size;
+    count_allocation(new_ptr);
+  }
+  return new_ptr;
+}
+
+void counting_free(void* ptr)
+{
+  if (ptr)
+    t_counters.m_live_bytes -= malloc_usable_size(ptr);
+  std::free(ptr);
+}
+
+char* counting_strdup(char const* str)
+{
+  std::size_t size = std::strlen(str) + 1;
+  char* ptr = static_cast<char*>(counting_malloc(size));
+  if (ptr)
+    std::memcpy(ptr, str, size);
+  return ptr;
+}
+
+// Install the allocation functions at startup: xmlMemSetup must not race with allocations of libxml2 in other threads.
+struct Installer
+{
+  Installer() { MemoryAccounting::install(); }
+} installer;
+
+} // namespace
+
+//static
+void MemoryAccounting::install()
+{
+  static std::once_flag s_installed;
+  std::call_once(s_installed, []{
+    if (xmlMemSetup(counting_free, counting_malloc, counting_realloc, counting_strdup) != 0)
+      Dout(dc::warning, "xmlMemSetup failed: libxml2 memory will not be accounted.");
+  });
+}
+
+MemoryAccounting::MemoryAccounting() : m_phase(number_of_phases), m_start_allocations(0), m_start_allocated_bytes(0), m_start_live_bytes(0)
+{
+  install();
+}
+
+void MemoryAccounting::begin(phase_type phase)
+{
+  // Phases do not nest.
+  ASSERT(m_phase == number_of_phases);
+  m_phase = phase;
+  m_stats[phase] = MemoryStats();
+  m_start_allocations = t_counters.m_allocations;
+  m_start_allocated_bytes = t_counters.m_allocated_bytes;
+  m_start_live_bytes = t_counters.m_peak_live_bytes = t_counters.m_live_bytes;
+}
+
+void MemoryAccounting::end()
+{
+  MemoryStats& stats = m_stats[m_phase];
+  stats.m_allocations = t_counters.m_allocations - m_start_allocations;
+  stats.m_allocated_bytes = t_counters.m_allocated_bytes - m_start_allocated_bytes;
+  stats.m_retained_bytes = t_counters.m_live_bytes - m_start_live_bytes;
+  stats.m_peak_bytes = t_counters.m_peak_live_bytes - m_start_live_bytes;
+  m_phase = number_of_phases;
+}
+
+void MemoryStats::print_on(std::ostream& os) const
+{
+  os << m_allocations << " libxml2 allocations of together " << m_allocated_bytes << " bytes (retained: " << m_retained_bytes <<
+    ", peak: " << m_peak_bytes << "); " << m_objects << " objects of together " << m_object_bytes << " bytes.";
+}
+
+void MemoryAccounting::print_on(std::ostream& os) const
+{
+  static char const* const names[number_of_phases] = { "parse", "deserialize", "write" };
+  for (int phase = 0; phase < number_of_phases; ++phase)
+  {
+    os << names[phase] << ": ";
+    m_stats[phase].print_on(os);
+    os << '\n';
+  }
+}
+
+} // namespace xml
@@ -0,0 +1,157 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class MemoryAccounting.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::MemoryStats
+ * \brief Allocation counts of one phase (parse, deserialize or write) of a Reader or Writer.
+ *
+ * \class xml::MemoryAccounting
+ * \brief Opt-in accounting of the memory used by a Reader or Writer.
+ *
+ * Call Bridge::enable_memory_accounting() on a Reader or Writer to
+ * collect, per phase, the number of allocations and bytes of libxml2
+ * (the DOM and parser buffers) and the number and size of the objects
+ * that were read or written with child() and children().
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Reader reader;
+ * reader.enable_memory_accounting();
+ * reader.parse(path, 1);
+ * reader.read(catalog);
+ * reader.memory_accounting()->print_on(std::cout);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The libxml2 allocations are counted by installing counting allocation
+ * functions with `xmlMemSetup` (see install()); they count the usable size
+ * of each allocation as reported by `malloc_usable_size`. Allocations are
+ * attributed to the thread that makes them, and frees to the thread that
+ * frees the memory. When memory is freed by another thread than the one that
+ * allocated it, for example the DOM fragments that Reader::parse_parallel
+ * builds on worker threads and later merges, the retained and peak bytes of
+ * both threads drift by that amount. Object sizes are `sizeof` the
+ * object only; memory that an object allocates itself is not included.
+ * The objects that are written by the threads of a parallel write (see
+ * WriteBridge::set_parallel) are included in the write phase.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace xml {
+
+struct MemoryStats
+{
+  uint64_t m_allocations = 0;		///< The number of allocations (including reallocations) by libxml2.
+  uint64_t m_allocated_bytes = 0;	///< The total number of bytes allocated by libxml2.
+  int64_t m_retained_bytes = 0;		///< The growth of libxml2 memory in use at the end of the phase; for parse this is the size of the DOM.
+  int64_t m_peak_bytes = 0;		///< The largest growth of libxml2 memory in use during the phase.
+  uint64_t m_objects = 0;		///< The number of objects read or written with child() or children().
+  uint64_t m_object_bytes = 0;		///< The sum of the sizes of those objects.
+
+  /// Write a human readable, single line summary to \a os.
+  void print_on(std::ostream& os) const;
+};
+
+class MemoryAccounting
+{
+  public:
+    /// The phases that are accounted separately.
+    enum phase_type
+    {
+      parse,			///< Reader::parse.
+      deserialize,		///< Reader::read.
+      write,			///< Writer::write.
+      number_of_phases
+    };
+
+    /// Begins a phase upon construction and ends it upon destruction.
+    class Phase
+    {
+      private:
+        MemoryAccounting* m_accounting;
+
+      public:
+        /// Begin phase \a phase of \a accounting, if not null.
+        Phase(MemoryAccounting* accounting, phase_type phase) : m_accounting(accounting) { if (m_accounting) m_accounting->begin(phase); }
+        /// End the phase.
+        ~Phase() { if (m_accounting) m_accounting->end(); }
+    };
+
+  private:
+    MemoryStats m_stats[number_of_phases];
+    phase_type m_phase;				// The current phase, or number_of_phases when not inside a phase.
+    uint64_t m_start_allocations;		// The per thread counters at the start of the current phase.
+    uint64_t m_start_allocated_bytes;
+    int64_t m_start_live_bytes;
+
+  public:
+    /// Construct a MemoryAccounting with all counts zero; calls install().
+    MemoryAccounting();
+
+    /**
+      * \brief Install the counting allocation functions into libxml2.
+      *
+      * This is done once per process, during static initialization of the
+      * library, so before any document is parsed; the overhead for threads that
+      * are not accounted is a few thread-local increments per allocation.
+      */
+    static void install();
+
+    /// Begin phase \a phase; the stats of that phase are reset.
+    void begin(phase_type phase);
+
+    /// End the current phase.
+    void end();
+
+    /// Count an object of \a size bytes that was read or written.
+    void count_object(std::size_t size)
+    {
+      if (m_phase != number_of_phases)
+      {
+        ++m_stats[m_phase].m_objects;
+        m_stats[m_phase].m_object_bytes += size;
+      }
+    }
+
+    /// Add the objects that \a other counted in phase \a phase to the current phase; used for the threads of a parallel write.
+    void add_objects(MemoryAccounting const& other, phase_type phase)
+    {
+      if (m_phase != number_of_phases)
+      {
+        m_stats[m_phase].m_objects += other.m_stats[phase].m_objects;
+        m_stats[m_phase].m_object_bytes += other.m_stats[phase].m_object_bytes;
+      }
+    }
+
+    /// Return the stats of the last run of phase \a phase.
+    MemoryStats const& stats(phase_type phase) const { return m_stats[phase]; }
+
+    /// Return the size of the DOM that was built by the last parse.
+    int64_t dom_bytes() const { return m_stats[parse].m_retained_bytes; }
+
+    /// Write the stats of all phases to \a os, one line per phase.
+    void print_on(std::ostream& os) const;
+};
+
+} // namespace xml
@@ -0,0 +1,42 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class OstreamSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "OstreamSink.h"
+#include <ostream>
+
+namespace xml {
+
+OstreamSink::~OstreamSink()
+{
+  sync();
+}
+
+void OstreamSink::write_out(char const* data, std::size_t len)
+{
+  m_os.write(data, len);
+  if (!m_os.good())
+    set_error("failed to write to stream");
+}
+
+} // namespace xml
@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class OutputSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "OutputSink.h"
+#include "utils/AIAlert.h"
+#include <algorithm>
+
+namespace xml {
+
+void OutputSink::append_slow(char const* data, std::size_t len)
+{
+  for (;;)
+  {
+    std::size_t chunk = std::min(len, static_cast<std::size_t>(m_end - m_pos));
+    std::memcpy(m_pos, data, chunk);
+    m_pos += chunk;
+    if ((len -= chunk) == 0)
+      break;
+    data += chunk;
+    overflow(std::min(len, max_reserve));
+  }
+}
+
+void OutputSink::fill_slow(char c, std::size_t count)
+{
+  for (;;)
+  {
+    std::size_t chunk = std::min(count, static_cast<std::size_t>(m_end - m_pos));
+    std::memset(m_pos, c, chunk);
+    m_pos += chunk;
+    if ((count -= chunk) == 0)
+      break;
+    overflow(std::min(count, max_reserve));
+  }
+}
+
+void OutputSink::flush()
+{
+  sync();
+  if (!m_error.empty())
+  {
+    THROW_ALERT("Failed to write XML output: [ERROR]", AIArgs("[ERROR]", m_error));
+  }
+}
+
+OutputSink::Streambuf::int_type OutputSink::Streambuf::overflow(int_type c)
+{
+  commit_put_area();
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    m_sink.put(traits_type::to_char_type(c));
+  else if (m_sink.m_pos == m_sink.m_end)
+    m_sink.overflow(1);
+  // The sink always has room left after a put or an overflow.
+  setp(m_sink.m_pos, m_sink.m_end);
+  return traits_type::not_eof(c);
+}
+
+std::streamsize OutputSink::Streambuf::xsputn(char const* s, std::streamsize n)
+{
+  if (n > 0 && n <= epptr() - pptr())
+  {
+    std::memcpy(pptr(), s, n);
+    pbump(n);
+    return n;
+  }
+  commit_put_area();
+  m_sink.append(s, n);
+  setp(m_sink.m_pos, m_sink.m_end);
+  return n;
+}
+
+int OutputSink::Streambuf::sync()
+{
+  commit_put_area();
+  // The sink may be written to directly now; the next output sets up the put area again.
+  setp(nullptr, nullptr);
+  return 0;
+}
+
+BufferedSink::BufferedSink(std::size_t buffer_size) : m_buffer(new char[std::max(buffer_size, max_reserve)])
+{
+  m_begin = m_pos = m_buffer.get();
+  m_end = m_begin + std::max(buffer_size, max_reserve);
+}
+
+void BufferedSink::overflow(std::size_t UNUSED_ARG(needed))
+{
+  // The buffer is at least max_reserve bytes, so emptying it always makes enough room.
+  sync();
+}
+
+void BufferedSink::sync()
+{
+  std::size_t len = m_pos - m_begin;
+  // Once an error occurred, the remaining output is discarded.
+  if (len > 0 && m_error.empty())
+    write_out(m_begin, len);
+  m_flushed += len;
+  m_pos = m_begin;
+}
+
+} // namespace xml
@@ -0,0 +1,194 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class OutputSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::OutputSink
+ * \brief Buffered destination of the bytes written by a WriteBridge.
+ *
+ * An OutputSink exposes a contiguous output buffer that can be appended
+ * to with plain `memcpy`s. When the buffer is full the backend
+ * (see FdSink, AsyncFdSink, FileSink, StringSink and OstreamSink) is asked to make room.
+ *
+ * Write errors of the backend are not reported immediately; they are
+ * remembered and thrown (as AIAlert::Error) by the next call to flush().
+ *
+ * \class xml::BufferedSink
+ * \brief Base class for sinks that own a fixed size buffer that is written out to the backend as a whole.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace xml {
+
+class OutputSink
+{
+  public:
+    static constexpr std::size_t default_buffer_size = 256 * 1024;	///< The default size of the output buffer.
+    static constexpr std::size_t max_reserve = 4096;			///< The largest size that may be passed to reserve().
+
+  protected:
+    char* m_begin;				///< The start of the current buffer.
+    char* m_pos;				///< The current write position.
+    char* m_end;				///< One past the end of the current buffer.
+    uint64_t m_flushed;				///< The number of bytes that were handed over to the backend so far.
+    std::string m_error;			///< A description of the first write error, or empty when no error occurred.
+
+  public:
+    /// Construct an OutputSink without a buffer.
+    OutputSink() : m_begin(nullptr), m_pos(nullptr), m_end(nullptr), m_flushed(0) { }
+
+    /// Virtual destructor.
+    virtual ~OutputSink() = default;
+
+    OutputSink(OutputSink const&) = delete;
+    OutputSink& operator=(OutputSink const&) = delete;
+
+    /// Append \a len bytes from \a data.
+    void append(char const* data, std::size_t len)
+    {
+      if (len <= static_cast<std::size_t>(m_end - m_pos))
+      {
+        std::memcpy(m_pos, data, len);
+        m_pos += len;
+      }
+      else
+        append_slow(data, len);
+    }
+
+    /// Append \a str.
+    void append(std::string_view str) { append(str.data(), str.size()); }
+
+    /// Append a single character.
+    void put(char c)
+    {
+      if (m_pos == m_end)
+        overflow(1);
+      *m_pos++ = c;
+    }
+
+    /// Append \a count times the character \a c.
+    void fill(char c, std::size_t count)
+    {
+      if (count > static_cast<std::size_t>(m_end - m_pos))
+      {
+        fill_slow(c, count);
+        return;
+      }
+      std::memset(m_pos, c, count);
+      m_pos += count;
+    }
+
+    /**
+      * \brief Return a pointer to at least \a len contiguous bytes of output buffer.
+      *
+      * \a len may not be larger than max_reserve.
+      * Call commit() afterwards with the number of bytes that were actually written.
+      */
+    char* reserve(std::size_t len)
+    {
+      if (len > static_cast<std::size_t>(m_end - m_pos))
+        overflow(len);
+      return m_pos;
+    }
+
+    /// Commit \a len bytes that were written to the pointer returned by reserve().
+    void commit(std::size_t len) { m_pos += len; }
+
+    /// Hand all buffered data over to the backend and throw if any write error occurred since construction.
+    void flush();
+
+    /// Return the total number of bytes appended so far.
+    uint64_t bytes_written() const { return m_flushed + (m_pos - m_begin); }
+
+    /// Return true if a write error occurred.
+    bool failed() const { return !m_error.empty(); }
+
+  protected:
+    /// Make room for at least \a needed (but no more than max_reserve) bytes; must leave m_pos < m_end.
+    virtual void overflow(std::size_t needed) = 0;
+
+    /// Hand all buffered data over to the backend.
+    virtual void sync() = 0;
+
+    /// Record a write error; only the first one is kept.
+    void set_error(std::string const& error) { if (m_error.empty()) m_error = error; }
+
+  private:
+    void append_slow(char const* data, std::size_t len);
+    void fill_slow(char c, std::size_t count);
+
+  public:
+    /**
+      * \brief A `std::streambuf` that appends everything written to it to an OutputSink.
+      *
+      * The put area is the free space of the output buffer of the sink. The bytes in it
+      * are only appended to the sink by sync() (`flush()` of the stream, or after every
+      * output operation when the stream has `std::unitbuf` set), which must be called
+      * before the sink is written to directly.
+      */
+    class Streambuf : public std::streambuf
+    {
+      private:
+        OutputSink& m_sink;
+
+      public:
+        /// Construct a Streambuf that writes to \a sink.
+        Streambuf(OutputSink& sink) : m_sink(sink) { }
+
+        /// Append what is left in the put area to the sink.
+        ~Streambuf() override { sync(); }
+
+      protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(char const* s, std::streamsize n) override;
+        int sync() override;
+
+      private:
+        // Advance the write position of the sink over the bytes in the put area.
+        void commit_put_area() { if (pbase()) m_sink.m_pos = pptr(); }
+    };
+};
+
+class BufferedSink : public OutputSink
+{
+  private:
+    std::unique_ptr<char[]> m_buffer;
+
+  protected:
+    /// Construct a BufferedSink with a buffer of \a buffer_size bytes.
+    BufferedSink(std::size_t buffer_size);
+
+    /// Write \a len bytes from \a data to the backend; call set_error upon failure.
+    virtual void write_out(char const* data, std::size_t len) = 0;
+
+    void overflow(std::size_t needed) override;
+    void sync() override;
+};
+
+} // namespace xml
@@ -0,0 +1,129 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class Profiler.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace xml {
+
+void Profiler::open(uint64_t UNUSED_ARG(bytes))
+{
+  m_frames.push_back({nullptr, {}, 0, {}});
+}
+
+void Profiler::end_element(Frame& frame, clock_type::time_point now, uint64_t bytes)
+{
+  if (!frame.m_stats)
+    return;
+  clock_type::duration inclusive = now - frame.m_start;
+  Stats& stats = *frame.m_stats;
+  ++stats.m_count;
+  stats.m_inclusive += inclusive;
+  stats.m_exclusive += inclusive - frame.m_children;
+  stats.m_bytes += bytes - frame.m_start_bytes;
+  frame.m_stats = nullptr;
+  // The elements of a frame are child elements of the current element of the frame below it.
+  if (&frame != &m_frames.front())
+    (&frame - 1)->m_children += inclusive;
+}
+
+void Profiler::element(std::string_view name, uint64_t bytes)
+{
+  // The root element might be read without a surrounding open_child().
+  if (m_frames.empty())
+    open(bytes);
+  auto now = clock_type::now();
+  Frame& frame = m_frames.back();
+  end_element(frame, now, bytes);
+  auto stats = m_stats.find(name);
+  if (stats == m_stats.end())
+    stats = m_stats.emplace(std::string(name), Stats()).first;
+  frame.m_stats = &stats->second;
+  frame.m_start = now;
+  frame.m_start_bytes = bytes;
+  frame.m_children = clock_type::duration::zero();
+}
+
+void Profiler::close(uint64_t bytes)
+{
+  if (m_frames.empty())
+    return;
+  end_element(m_frames.back(), clock_type::now(), bytes);
+  m_frames.pop_back();
+}
+
+void Profiler::close_frames(std::size_t depth)
+{
+  while (m_frames.size() > depth)
+    close(m_frames.back().m_start_bytes);
+}
+
+void Profiler::no_child_left(std::string_view name)
+{
+  // The element that was just started by element(name) doesn't exist.
+  if (!m_frames.empty())
+    m_frames.back().m_stats = nullptr;
+  auto stats = m_stats.find(name);
+  if (stats == m_stats.end())
+    stats = m_stats.emplace(std::string(name), Stats()).first;
+  ++stats->second.m_no_child_left;
+}
+
+void Profiler::reset()
+{
+  m_stats.clear();
+  m_frames.clear();
+}
+
+std::vector<Profiler::Entry> Profiler::report() const
+{
+  std::vector<Entry> entries;
+  for (auto const& [name, stats] : m_stats)
+    entries.push_back({name, stats.m_count, stats.m_inclusive, stats.m_exclusive, stats.m_no_child_left, stats.m_bytes});
+  std::stable_sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b){ return a.m_exclusive > b.m_exclusive; });
+  return entries;
+}
+
+void Profiler::print_on(std::ostream& os) const
+{
+  using std::chrono::duration;
+  std::vector<Entry> entries = report();
+  std::size_t width = 7;
+  for (Entry const& entry : entries)
+    width = std::max(width, entry.m_name.size());
+  os << std::left << std::setw(width) << "element" << std::right << std::setw(12) << "count" << std::setw(15) << "inclusive ms" <<
+    std::setw(15) << "exclusive ms" << std::setw(12) << "ns/element" << std::setw(14) << "no child left" << std::setw(14) << "bytes" << '\n';
+  for (Entry const& entry : entries)
+  {
+    double const exclusive_ns = duration<double, std::nano>(entry.m_exclusive).count();
+    os << std::left << std::setw(width) << entry.m_name << std::right << std::setw(12) << entry.m_count << std::fixed << std::setprecision(3) <<
+      std::setw(15) << duration<double, std::milli>(entry.m_inclusive).count() << std::setw(15) << exclusive_ns / 1e6 <<
+      std::setw(12) << std::setprecision(1) << (entry.m_count ? exclusive_ns / entry.m_count : 0.0) <<
+      std::setw(14) << entry.m_no_child_left << std::setw(14) << entry.m_bytes << '\n';
+  }
+}
+
+} // namespace xml
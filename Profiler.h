@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class Profiler.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::Profiler
+ * \brief Per element name timing and counters of a Reader or Writer.
+ *
+ * Pass a Profiler to Bridge::set_profiler to accumulate, per element
+ * name, the number of elements read or written, their inclusive time
+ * (including child elements) and exclusive time, the number of
+ * NoChildLeft exceptions thrown while looking for an element with that
+ * name (reading) and the number of bytes written (writing).
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Profiler profiler;
+ * xml::Reader reader;
+ * reader.set_profiler(&profiler);
+ * reader.parse(path, 1);
+ * reader.read(catalog);
+ * profiler.print_on(std::cout);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Use Reader::read to read the root element, otherwise the root element
+ * itself is not accounted. When no profiler is set the overhead is a
+ * test of a null pointer per element. A Profiler may be shared by
+ * several Readers and Writers, but only within one thread; the threads
+ * of a parallel children() write are not profiled.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xml {
+
+class Profiler
+{
+  public:
+    using clock_type = std::chrono::steady_clock;
+
+    /// The accumulated results for one element name.
+    struct Entry
+    {
+      std::string m_name;			///< The name of the element.
+      uint64_t m_count;				///< The number of elements that were read or written.
+      clock_type::duration m_inclusive;		///< The total time spent in these elements, including their child elements.
+      clock_type::duration m_exclusive;		///< The total time spent in these elements, excluding their child elements.
+      uint64_t m_no_child_left;			///< The number of times a NoChildLeft was thrown while looking for an element with this name.
+      uint64_t m_bytes;				///< The number of bytes written for these elements, including their child elements.
+    };
+
+  private:
+    struct Stats
+    {
+      uint64_t m_count = 0;
+      clock_type::duration m_inclusive{};
+      clock_type::duration m_exclusive{};
+      uint64_t m_no_child_left = 0;
+      uint64_t m_bytes = 0;
+    };
+
+    // The elements of one open_child() / close_child() pair; they are processed one after another.
+    struct Frame
+    {
+      Stats* m_stats;				// The stats of the current element, or null if there is no current element.
+      clock_type::time_point m_start;		// The start of the current element.
+      uint64_t m_start_bytes;			// The number of bytes written at the start of the current element.
+      clock_type::duration m_children;		// The inclusive time of the child elements of the current element so far.
+    };
+
+    std::map<std::string, Stats, std::less<>> m_stats;
+    std::vector<Frame> m_frames;
+
+  public:
+    /// Return the results per element name, sorted by exclusive time (largest first).
+    std::vector<Entry> report() const;
+
+    /// Write report() as a table to \a os.
+    void print_on(std::ostream& os) const;
+
+    /// Discard all results.
+    void reset();
+
+    /// @cond Doxygen_Suppress
+    // Called by Bridge; bytes is the number of bytes written so far (zero when reading).
+    void open(uint64_t bytes);
+    void element(std::string_view name, uint64_t bytes);
+    void close(uint64_t bytes);
+    void no_child_left(std::string_view name);
+
+    // Upon destruction, closes the frames that were opened since construction; upon construction
+    // opens one if open_frame is set (for the root element that Reader::read reads). If an exception
+    // is thrown, that also closes the frames of the elements that were being processed; the bytes
+    // written for those are not counted.
+    class Scope
+    {
+      private:
+        Profiler* m_profiler;			// Null when not profiling.
+        std::size_t m_depth;			// The number of frames upon construction.
+
+      public:
+        Scope(Profiler* profiler, bool open_frame) : m_profiler(profiler), m_depth(profiler ? profiler->m_frames.size() : 0)
+        {
+          if (m_profiler && open_frame)
+            m_profiler->open(0);
+        }
+        ~Scope() { if (m_profiler) m_profiler->close_frames(m_depth); }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    };
+    /// @endcond
+
+  private:
+    void end_element(Frame& frame, clock_type::time_point now, uint64_t bytes);
+    // Close frames until only depth frames are left, without counting bytes for them.
+    void close_frames(std::size_t depth);
+};
+
+} // namespace xml
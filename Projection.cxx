@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class Projection.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "Projection.h"
+#include <ostream>
+
+namespace xml {
+
+void Projection::add(std::string_view parent, std::string_view child)
+{
+  auto names = m_children.find(parent);
+  if (names == m_children.end())
+    names = m_children.emplace(std::string(parent), names_type()).first;
+  if (names->second.find(child) == names->second.end())
+    names->second.emplace(child);
+}
+
+void Projection::keep_subtree(std::string_view name)
+{
+  if (m_subtrees.find(name) == m_subtrees.end())
+    m_subtrees.emplace(name);
+}
+
+bool Projection::keeps(std::string_view parent, std::string_view child) const
+{
+  auto names = m_children.find(parent);
+  return names != m_children.end() && names->second.find(child) != names->second.end();
+}
+
+void Projection::print_on(std::ostream& os) const
+{
+  for (auto const& entry : m_children)
+  {
+    os << '<' << entry.first << ">:";
+    for (std::string const& child : entry.second)
+      os << " <" << child << '>';
+    os << '\n';
+  }
+  for (std::string const& name : m_subtrees)
+    os << '<' << name << ">: *\n";
+}
+
+} // namespace xml
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class Projection.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::Projection
+ * \brief The set of element names that the xml() methods of a type actually read.
+ *
+ * A Projection maps the name of a parent element to the names of the
+ * child elements that are requested from it. Reader::parse(file, version, projection)
+ * uses it to drop every other subtree while parsing: those elements are
+ * skipped at the SAX level and no DOM nodes are ever created for them.
+ * Text, attributes and the root element are always kept, except text
+ * between a dropped element and the next kept one when there is text before
+ * the dropped element: libxml2 would merge the two, while only the first
+ * text node is read.
+ *
+ * A Projection is either declared with add() and keep_subtree(), or learned
+ * by reading a representative document with Reader::learn_projection.
+ * Note that a learned Projection only contains the children that were
+ * requested while reading that document, which includes optional children
+ * that were requested but absent, but not children that are only requested
+ * by code paths that did not run (for example, another version_major).
+ *
+ * Element names are matched without namespace prefix, as Element::get_name() returns them.
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Projection projection;
+ * {
+ *   xml::Reader reader;
+ *   reader.learn_projection(&projection);
+ *   reader.parse("sample.xml", 1);
+ *   reader.read(catalog);
+ * }
+ * xml::Reader reader;
+ * reader.parse("huge.xml", 1, projection);     // Vendor extensions are never built.
+ * reader.read(catalog);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+
+#pragma once
+
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+
+namespace xml {
+
+class Projection
+{
+  private:
+    using names_type = std::set<std::string, std::less<>>;
+    std::map<std::string, names_type, std::less<>> m_children;	// The requested child names, per parent name.
+    names_type m_subtrees;						// Elements whose whole subtree is kept.
+
+  public:
+    /// Record that children with name \a child are requested from elements with name \a parent.
+    void add(std::string_view parent, std::string_view child);
+
+    /// Keep everything below elements with name \a name (for example, content that is read as a whole).
+    void keep_subtree(std::string_view name);
+
+    /// Return true if nothing was added yet (an empty Projection would drop everything but the root element).
+    bool empty() const { return m_children.empty() && m_subtrees.empty(); }
+
+    /// Return true if child elements with name \a child of an element with name \a parent must be kept.
+    bool keeps(std::string_view parent, std::string_view child) const;
+
+    /// Return true if the subtree of elements with name \a name is kept entirely.
+    bool keeps_subtree(std::string_view name) const { return m_subtrees.find(name) != m_subtrees.end(); }
+
+    /// Write the projection to \a os in a human readable form, one parent per line.
+    void print_on(std::ostream& os) const;
+};
+
+} // namespace xml
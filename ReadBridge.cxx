@@ -23,6 +23,7 @@
 
 #include "sys.h"
 #include "Reader.h"
+#include "Projection.h"
 #include "utils/AIAlert.h"
 #include "debug.h"
 #include <libxml++/libxml++.h>
@@ -30,9 +31,9 @@
 
 namespace xml {
 
-void ReadBridge::state_type::refresh_children(Glib::ustring const& name)
+void ReadBridge::state_type::refresh_children(xmlpp::Element const* parent, Glib::ustring const& name)
 {
-  m_current_parent = m_element;
+  m_current_parent = parent;
   m_current_child_name = name;
   m_child_list = m_current_parent->get_children(m_current_child_name);
   m_current_child = m_child_list.begin();
@@ -81,7 +82,8 @@ void ReadBridge::state_type::node_name(char const* name_ptr, xmlpp::Element cons
   {
     if (m_element->get_parent() != m_current_parent || m_current_child_name != name)
     {
-      refresh_children(name);
+      // A different name requested after reading a child looks for siblings of that child.
+      refresh_children(requested_parent(), name);
     }
     else if (m_current_child != m_child_list.end())
     {
@@ -93,21 +95,96 @@ void ReadBridge::state_type::node_name(char const* name_ptr, xmlpp::Element cons
   }
 }
 
+xmlpp::Element const* ReadBridge::consumed_element(char const* name) const
+{
+  // node_name advances to the next child when it is called for a sibling of the current element with the same name.
+  if (!m_state.m_element || m_state.m_current_child == m_state.m_child_list.end() ||
+      m_state.m_element->get_parent() != m_state.m_current_parent || m_state.m_current_child_name != name)
+    return nullptr;
+  return m_state.m_element;
+}
+
+void ReadBridge::release_element(xmlpp::Element const* element)
+{
+  Dout(dc::xmlparser, "Releasing element <" << element->get_name() << "> line " << element->get_line() << ".");
+  xmlpp::Element* node = const_cast<xmlpp::Element*>(element);
+#if XMLPP_VERSION >= 30
+  xmlpp::Node::remove_node(node);
+#else
+  node->get_parent()->remove_child(node);
+#endif
+}
+
+void ReadBridge::node_name(char const* name)
+{
+  // Record the request before looking up the child, so that absent optional children are learned too.
+  if (m_projection_learner && m_state.m_element &&
+      (m_state.m_element->get_parent() != m_state.m_current_parent || m_state.m_current_child_name != name))
+    m_projection_learner->add(m_state.requested_parent()->get_name().raw(), name);
+  xmlpp::Element const* consumed = m_release_consumed ? consumed_element(name) : nullptr;
+  if (!m_profiler && !consumed)
+  {
+    m_state.node_name(name, m_root_element);
+    return;
+  }
+  profile_element(name);
+  try
+  {
+    m_state.node_name(name, m_root_element);
+  }
+  catch (NoChildLeft const&)
+  {
+    if (m_profiler)
+      m_profiler->no_child_left(name);
+    if (consumed)
+      release_element(consumed);
+    throw;
+  }
+  if (consumed)
+    release_element(consumed);
+}
+
+_xmlAttr const* ReadBridge::find_attribute(char const* name) const
+{
+  // Like xmlpp::Element::get_attribute, this also finds attributes with a default value in the DTD, but without creating a wrapper.
+  return xmlHasProp(const_cast<xmlNode*>(m_state.m_element->cobj()), reinterpret_cast<xmlChar const*>(name));
+}
+
+std::string_view ReadBridge::attribute_value(_xmlAttr const* attribute) const
+{
+  if (attribute->type == XML_ATTRIBUTE_DECL)
+  {
+    xmlChar const* value = reinterpret_cast<xmlAttribute const*>(attribute)->defaultValue;
+    return value ? std::string_view(reinterpret_cast<char const*>(value)) : std::string_view();
+  }
+  xmlNode const* text = attribute->children;
+  if (!text)
+    return {};
+  if (!text->next && text->type == XML_TEXT_NODE)
+    return text->content ? std::string_view(reinterpret_cast<char const*>(text->content)) : std::string_view();
+  // Entity references that were not substituted (all parsers here use XML_PARSE_NOENT, so this shouldn't happen).
+  xmlChar* value = xmlNodeListGetString(attribute->doc, text, 1);
+  m_value_buffer = value ? reinterpret_cast<char const*>(value) : "";
+  xmlFree(value);
+  return m_value_buffer;
+}
+
 void ReadBridge::attribute(char const* name, char const* value)
 {
   xmlpp::Element const* element = m_state.m_element;
-  xmlpp::Attribute const* attribute = element->get_attribute(name);
+  _xmlAttr const* attribute = find_attribute(name);
   if (!attribute)
   {
     THROW_ALERT("Element <[ELEMENTNAME]> at line [LINE] does not have attribute '[NAME]'.",
 	AIArgs("[ELEMENTNAME]", element->get_name())("[LINE]", element->get_line())("[NAME]", name));
   }
-  if (attribute->get_value() != value)
+  std::string_view const attribute_str = attribute_value(attribute);
+  if (attribute_str != value)
   {
     THROW_ALERT("Wrong attribute '[NAME]' in node <[ELEMENTNAME]> (line [LINE]); value is \"[VALUE]\", expected \"[EXPECTED]\".",
-	AIArgs("[NAME]", name)("[ELEMENTNAME]", element->get_name())("[LINE]", element->get_line())("[VALUE]", attribute->get_value())("[EXPECTED]", value));
+	AIArgs("[NAME]", name)("[ELEMENTNAME]", element->get_name())("[LINE]", element->get_line())("[VALUE]", std::string(attribute_str))("[EXPECTED]", value));
   }
-  Dout(dc::xmlparser, "Found attribute '" << attribute->get_name() << "=\"" << attribute->get_value() << "\"'.");
+  Dout(dc::xmlparser, "Found attribute '" << name << "=\"" << attribute_str << "\"'.");
 }
 
 void ReadBridge::child(char const* name, char const* value)
@@ -117,7 +194,7 @@ void ReadBridge::child(char const* name, char const* value)
   {
     xmlpp::Element const* element = dynamic_cast<xmlpp::Element const*>(*m_state.m_current_child);
     THROW_ALERT("Element <[NAME]> (line [LINE]) has value \"[VALUE]\", expected \"[EXPECTED]\".",
-	AIArgs("[NAME]", name)("[LINE]", element->get_line())("[VALUE]", read_child_stream())("[EXPECTED]", value));
+	AIArgs("[NAME]", name)("[LINE]", element->get_line())("[VALUE]", std::string(read_child_stream()))("[EXPECTED]", value));
   }
   close_child();
 }
@@ -131,6 +208,15 @@ void ReadBridge::state_type::swap(state_type& state)
   std::swap(m_element, state.m_element);
 }
 
+void ReadBridge::reset_state()
+{
+  state_type fresh_state;
+  m_state.swap(fresh_state);
+  m_state_stack = {};
+  Bridge::m_state_stack = {};
+  Bridge::m_state.m_depth = 0;
+}
+
 void ReadBridge::open_child()
 {
   DoutEntering(dc::xmlparser, "ReadBridge::open_child()");
@@ -149,52 +235,103 @@ void ReadBridge::open_child(char const* name)
   DoutEntering(dc::xmlparser, "ReadBridge::open_child(\"" << name << "\")");
 
   open_child();
-  m_state.refresh_children(name);
-  m_state.get_element();
+  if (m_projection_learner)
+    m_projection_learner->add(m_state.m_element->get_name().raw(), name);
+  m_state.refresh_children(m_state.m_element, name);
+  if (!m_profiler)
+  {
+    m_state.get_element();
+    return;
+  }
+  profile_element(name);
+  try
+  {
+    m_state.get_element();
+  }
+  catch (NoChildLeft const&)
+  {
+    m_profiler->no_child_left(name);
+    throw;
+  }
 }
 
 void ReadBridge::next_child()
 {
   // Call get_element() (open_child(name) or next_child()) before calling next_child().
   ASSERT(m_state.m_current_child != m_state.m_child_list.end());
-  ++m_state.m_current_child;
-  m_state.get_element();
+  xmlpp::Node const* consumed = *m_state.m_current_child++;
+  if (m_release_consumed)
+    if (xmlpp::Element const* element = dynamic_cast<xmlpp::Element const*>(consumed))
+      release_element(element);
+  if (!m_profiler)
+  {
+    m_state.get_element();
+    return;
+  }
+  std::string const& name = m_state.m_current_child_name.raw();
+  profile_element(name);
+  try
+  {
+    m_state.get_element();
+  }
+  catch (NoChildLeft const&)
+  {
+    m_profiler->no_child_left(name);
+    throw;
+  }
 }
 
-bool ReadBridge::read_attribute(char const* name, std::string& attribute_str, bool mandatory) const
+bool ReadBridge::read_attribute(char const* name, std::string_view& attribute_str, bool mandatory) const
 {
-  xmlpp::Element const* element = m_state.m_element;
-  xmlpp::Attribute const* attribute = element->get_attribute(name);
+  _xmlAttr const* attribute = find_attribute(name);
   if (!attribute)
   {
     if (mandatory)
     {
+      xmlpp::Element const* element = m_state.m_element;
       THROW_ALERT("Element <[ELEMENTNAME]> at line [LINE] does not have attribute '[NAME]'.",
 	  AIArgs("[ELEMENTNAME]", element->get_name())("[LINE]", element->get_line())("[NAME]", name));
     }
     return false;
   }
-  attribute_str = attribute->get_value();
-  Dout(dc::xmlparser, "Read attribute '" << attribute->get_name() << "=\"" << attribute->get_value() << "\"'.");
+  attribute_str = attribute_value(attribute);
+  Dout(dc::xmlparser, "Read attribute '" << name << "=\"" << attribute_str << "\"'.");
   return true;
 }
 
-std::string ReadBridge::read_child_stream()
+std::string_view ReadBridge::read_child_stream()
 {
   xmlpp::Element const* node = dynamic_cast<xmlpp::Element const*>(*m_state.m_current_child);
   // Call get_element() (open_child(name) or next_child()) before calling read_child_stream.
   ASSERT(node);
-#if XMLPP_VERSION >= 30
-  xmlpp::TextNode const* textnode = node->get_first_child_text();
-#else
-  xmlpp::TextNode const* textnode = node->get_child_text();
-#endif
-  if (!textnode)
+  // The first text node, like xmlpp::Element::get_first_child_text, but without creating a wrapper.
+  for (xmlNode const* child = node->cobj()->children; child; child = child->next)
+    if (child->type == XML_TEXT_NODE)
+      return child->content ? std::string_view(reinterpret_cast<char const*>(child->content)) : std::string_view();
+  Dout(dc::xmlparser, "ReadBridge::read_child_stream(): (xmlpp::Element*)\"" << node->get_name() << "\") has no text node. Returning empty string.");
+  return {};
+}
+
+std::size_t ReadBridge::children_count_hint() const
+{
+  // After open_child(name) the children with that name are already loaded.
+  if (!m_state.m_child_list.empty())
+    return m_state.m_child_list.size();
+  if (!m_state.m_element)
+    return 0;
+  // Otherwise the name is not known yet: only count the child elements when they all have the same name.
+  std::size_t count = 0;
+  xmlChar const* name = nullptr;
+  for (xmlNode const* child = m_state.m_element->cobj()->children; child; child = child->next)
   {
-    Dout(dc::xmlparser, "ReadBridge::read_child_stream(): (xmlpp::Element*)\"" << node->get_name() << "\") has no text node. Returning empty string.");
-    return "";
+    if (child->type != XML_ELEMENT_NODE)
+      continue;
+    if (name && !xmlStrEqual(name, child->name))
+      return 0;
+    name = child->name;
+    ++count;
   }
-  return textnode->get_content();
+  return count;
 }
 
 void ReadBridge::close_child()
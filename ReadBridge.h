@@ -34,14 +34,19 @@
 
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <stack>
 
+struct _xmlAttr;
+
 namespace xmlpp {
 class Element;
 } // namespace xmlpp
 
 namespace xml {
 
+class Projection;
+
 class ReadBridge : public Bridge
 {
   public:
@@ -59,7 +64,9 @@ class ReadBridge : public Bridge
       * On subsequent calls to node_name() with the same name
       * and parent, only m_current_child is advanced until there
       * are not children left with that name (causing the exception
-      * NoChildLeft to be thrown).
+      * NoChildLeft to be thrown). A different name requested while
+      * m_element is one of those children loads the siblings of
+      * m_element with that name, not the children of m_element.
       */
     struct state_type {
       xmlpp::Element const* m_current_parent;			///< The parent element of the list in m_child_list.
@@ -79,7 +86,9 @@ class ReadBridge : public Bridge
       state_type(xmlpp::Element const* element) : m_current_parent(NULL), m_current_child(m_child_list.end()), m_element(element) { }
 
       void swap(state_type& state);				///< Swap the contents with \a state, preventing a copy of m_child_list and therefore keeping iterators to it valid.
-      void refresh_children(Glib::ustring const& name);		///< Load children with name \a name.
+      void refresh_children(xmlpp::Element const* parent, Glib::ustring const& name);	///< Load the children of \a parent with name \a name.
+      /// Return the element whose children node_name() looks for: m_current_parent while m_element is one of its children, otherwise m_element.
+      xmlpp::Element const* requested_parent() const { return m_current_parent && m_element->get_parent() == m_current_parent ? m_current_parent : m_element; }
       void get_element();					///< If m_current_child does not point to an xmlpp::Element, advance it till it does (or reaches the end of the list).
       /**
         * \brief Initialize the state data.
@@ -100,6 +109,9 @@ class ReadBridge : public Bridge
     xmlpp::Element const* m_root_element;			///< The root element of the document.
     state_type m_state;						///< State information.
     std::stack<state_type> m_state_stack;			///< Stored state information of parent elements.
+    Projection* m_projection_learner;				///< If non-null, the requested element names are added to this Projection.
+    bool m_release_consumed;					///< If true, elements are freed as soon as the next sibling with the same name is read.
+    mutable std::string m_value_buffer;				///< The value of the last attribute that is not stored contiguously in the document.
 
   public:
     /// Return the internal state of the ReadBridge.
@@ -107,10 +119,13 @@ class ReadBridge : public Bridge
 
   protected:
     /// Construct an uninitialized ReadBridge.
-    ReadBridge() : Bridge(0), m_root_element(NULL) { }
+    ReadBridge() : Bridge(0), m_root_element(NULL), m_projection_learner(NULL), m_release_consumed(false) { }
+
+    /// Start reading at the root element again, also when a previous read threw; called after parsing a new document.
+    void reset_state();
 
     /*virtual*/ bool writing() const { return false; }
-    /*virtual*/ void node_name(char const* name) { m_state.node_name(name, m_root_element); }
+    /*virtual*/ void node_name(char const* name);
     /*virtual*/ void attribute(char const* name, char const* value);
     /*virtual*/ void child(const char*, const char*);
 
@@ -121,9 +136,20 @@ class ReadBridge : public Bridge
     /*virtual*/ void close_child();
     /*virtual*/ void get_element();
     /*virtual*/ void next_child();
-    /*virtual*/ bool read_attribute(char const* name, std::string& attribute_str, bool mandatory) const;
-    /*virtual*/ std::string read_child_stream();
+    /*virtual*/ bool read_attribute(char const* name, std::string_view& attribute_str, bool mandatory) const;
+    /*virtual*/ std::string_view read_child_stream();
+    /*virtual*/ std::size_t children_count_hint() const;
 /// @endcond
+
+  private:
+    // Return the element that node_name(name) is going to move past, or null.
+    xmlpp::Element const* consumed_element(char const* name) const;
+    // Unlink element from the document and free it.
+    void release_element(xmlpp::Element const* element);
+    // Return the attribute of the current element with name name, or null.
+    _xmlAttr const* find_attribute(char const* name) const;
+    // Return the value of attribute.
+    std::string_view attribute_value(_xmlAttr const* attribute) const;
 };
 
 } // namespace xml
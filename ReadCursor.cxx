@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class ReadCursor.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "ReadCursor.h"
+#include "Reader.h"
+#include "debug.h"
+
+namespace xml {
+
+ReadCursor::ReadCursor(Reader const& reader) : m_document_root(reader.root_element())
+{
+  // Call Reader::freeze() after parsing and before creating cursors.
+  ASSERT(reader.frozen());
+  m_root_element = m_document_root;
+  set_version(reader.version());
+}
+
+bool ReadCursor::read_first_match(ElementPath const& path, std::function<void()> const& read)
+{
+  bool found = false;
+  try
+  {
+    path.for_each_match(m_document_root, [&](xmlpp::Element const* element){
+      found = true;
+      reset_state();
+      m_root_element = element;
+      read();
+      return false;
+    });
+  }
+  catch (...)
+  {
+    m_root_element = m_document_root;
+    throw;
+  }
+  m_root_element = m_document_root;
+  return found;
+}
+
+} // namespace xml
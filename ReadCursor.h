@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class ReadCursor.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::ReadCursor
+ * \brief Reads objects from a document that is owned by a Reader, concurrently with other cursors.
+ *
+ * A Reader keeps the traversal state of deserialization in itself, so
+ * only one thread at a time can read from it. A ReadCursor only holds
+ * that traversal state; the document stays in the Reader. Any number of
+ * threads can each create a ReadCursor for the same Reader and read the
+ * same or different elements at the same time.
+ *
+ * Reading a document normally creates the libxml++ wrappers of nodes on
+ * first access, which modifies the document. Therefore the Reader must
+ * be frozen first: Reader::freeze() creates all wrappers up front. After
+ * that the document is only read. Don't parse a new document with the
+ * Reader while cursors are in use.
+ *
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Reader reader;
+ * reader.parse(config_path, 1);
+ * reader.freeze();
+ * // In any number of threads:
+ * xml::ReadCursor cursor(reader);
+ * Config config;
+ * cursor.read(config);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+
+#pragma once
+
+#include "ReadBridge.h"
+#include "ElementPath.h"
+#include "Tracer.h"
+
+#include <functional>
+#include <string_view>
+
+namespace xml {
+
+class Reader;
+
+class ReadCursor : public ReadBridge
+{
+  private:
+    xmlpp::Element const* m_document_root;	// The root element of the document of the Reader.
+
+  public:
+    /// Construct a cursor at the root element of the document of \a reader, which must be frozen.
+    ReadCursor(Reader const& reader);
+
+    /// Read \a object from the root element of the document.
+    template<typename T>
+      void read(T& object);
+
+    /**
+      * \brief Read \a object from the first element that matches \a path.
+      *
+      * The matching element is read as if it were the root element; see Reader::read_at.
+      *
+      * \returns True if a matching element was found.
+      */
+    template<typename T>
+      bool read_at(ElementPath const& path, T& object);
+
+    /// Read \a object from the first element that matches \a path. The path is compiled on every call.
+    template<typename T>
+      bool read_at(std::string_view path, T& object) { return read_at(ElementPath(path), object); }
+
+  private:
+    // Call read() with the first element that matches path being the root element.
+    bool read_first_match(ElementPath const& path, std::function<void()> const& read);
+};
+
+template<typename T>
+void ReadCursor::read(T& object)
+{
+  Tracer::Scope trace("ReadCursor::read");
+  reset_state();
+  object.xml(*this);
+}
+
+template<typename T>
+bool ReadCursor::read_at(ElementPath const& path, T& object)
+{
+  return read_first_match(path, [&object, this]{ object.xml(*this); });
+}
+
+} // namespace xml
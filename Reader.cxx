@@ -24,15 +24,189 @@
 #include "sys.h"
 #include "utils/AIAlert.h"
 #include "Reader.h"
-#include <boost/filesystem/fstream.hpp>
+#include "RecordSplitter.h"
+#include "debug.h"
+#include <iostream>
+#include <libxml/parserInternals.h>
+#include <libxml/SAX2.h>
 
 namespace fs = boost::filesystem;
 
 namespace xml {
 
-Reader::Reader()
+namespace {
+
+// The state of a parse with a Projection; stored in the _private field of the parser context.
+struct ProjectionFilter
+{
+  Projection const& m_projection;
+  xmlSAXHandler m_default_sax;		// The SAX2 handlers that build the tree.
+  int m_skip_depth;			// Larger than zero while inside a dropped subtree.
+  int m_subtree_depth;			// Larger than zero while inside a subtree that is kept entirely.
+  xmlNode const* m_text_before_skip;	// The text or CDATA node that was the last child when a child element was dropped, or null.
+
+  ProjectionFilter(Projection const& projection) : m_projection(projection), m_skip_depth(0), m_subtree_depth(0), m_text_before_skip(nullptr)
+  {
+    xmlSAXVersion(&m_default_sax, 2);
+  }
+
+  static ProjectionFilter& from(void* ctx) { return *static_cast<ProjectionFilter*>(static_cast<xmlParserCtxtPtr>(ctx)->_private); }
+
+  // Return true if content of type would be appended to the text or CDATA node that preceded a dropped child.
+  // Without the projection that content would become a separate node after the child, and only the first
+  // text node is read (see ReadBridge::read_child_stream), so such content is ignored instead.
+  bool follows_dropped_child(void* ctx, xmlElementType type) const
+  {
+    xmlNode const* parent = static_cast<xmlParserCtxtPtr>(ctx)->node;
+    return m_text_before_skip && parent && parent->last == m_text_before_skip && m_text_before_skip->type == type;
+  }
+
+  static void start_element(void* ctx, xmlChar const* localname, xmlChar const* prefix, xmlChar const* URI,
+      int nb_namespaces, xmlChar const** namespaces, int nb_attributes, int nb_defaulted, xmlChar const** attributes)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth > 0)
+    {
+      ++filter.m_skip_depth;
+      return;
+    }
+    if (filter.m_subtree_depth > 0)
+      ++filter.m_subtree_depth;
+    else
+    {
+      // The node that is being built is the parent of this element (or null for the root element).
+      xmlNode const* parent = static_cast<xmlParserCtxtPtr>(ctx)->node;
+      if (parent && !filter.m_projection.keeps(reinterpret_cast<char const*>(parent->name), reinterpret_cast<char const*>(localname)))
+      {
+        filter.m_skip_depth = 1;
+        // libxml2 would merge text after the dropped child into this text node.
+        if (parent->last && (parent->last->type == XML_TEXT_NODE || parent->last->type == XML_CDATA_SECTION_NODE))
+          filter.m_text_before_skip = parent->last;
+        return;
+      }
+      if (filter.m_projection.keeps_subtree(reinterpret_cast<char const*>(localname)))
+        filter.m_subtree_depth = 1;
+    }
+    filter.m_default_sax.startElementNs(ctx, localname, prefix, URI, nb_namespaces, namespaces, nb_attributes, nb_defaulted, attributes);
+  }
+
+  static void end_element(void* ctx, xmlChar const* localname, xmlChar const* prefix, xmlChar const* URI)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth > 0)
+    {
+      --filter.m_skip_depth;
+      return;
+    }
+    if (filter.m_subtree_depth > 0)
+      --filter.m_subtree_depth;
+    filter.m_default_sax.endElementNs(ctx, localname, prefix, URI);
+  }
+
+  static void characters(void* ctx, xmlChar const* ch, int len)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0 && !filter.follows_dropped_child(ctx, XML_TEXT_NODE))
+      filter.m_default_sax.characters(ctx, ch, len);
+  }
+
+  static void ignorable_whitespace(void* ctx, xmlChar const* ch, int len)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0 && !filter.follows_dropped_child(ctx, XML_TEXT_NODE))
+      filter.m_default_sax.ignorableWhitespace(ctx, ch, len);
+  }
+
+  static void cdata_block(void* ctx, xmlChar const* value, int len)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0 && !filter.follows_dropped_child(ctx, XML_CDATA_SECTION_NODE))
+      filter.m_default_sax.cdataBlock(ctx, value, len);
+  }
+
+  static void comment(void* ctx, xmlChar const* value)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0)
+      filter.m_default_sax.comment(ctx, value);
+  }
+
+  static void processing_instruction(void* ctx, xmlChar const* target, xmlChar const* data)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0)
+      filter.m_default_sax.processingInstruction(ctx, target, data);
+  }
+
+  static void reference(void* ctx, xmlChar const* name)
+  {
+    ProjectionFilter& filter = from(ctx);
+    if (filter.m_skip_depth == 0)
+      filter.m_default_sax.reference(ctx, name);
+  }
+
+  // Errors are reported by the exception that Reader::parse throws, not on stderr.
+  // A template, because the constness of the error parameter differs between libxml2 versions.
+  template<typename ERROR>
+  static void ignore_error(void*, ERROR)
+  {
+  }
+
+  // Return the default handlers with the content callbacks replaced by the filtering ones above.
+  xmlSAXHandler sax_handler() const
+  {
+    xmlSAXHandler sax = m_default_sax;
+    sax.startElementNs = &start_element;
+    sax.endElementNs = &end_element;
+    sax.characters = &characters;
+    sax.ignorableWhitespace = &ignorable_whitespace;
+    sax.cdataBlock = &cdata_block;
+    sax.comment = &comment;
+    sax.processingInstruction = &processing_instruction;
+    sax.reference = &reference;
+    sax.serror = &ignore_error;
+    return sax;
+  }
+};
+
+struct ParserCtxtDeleter
+{
+  void operator()(xmlParserCtxtPtr ctxt) const
+  {
+    if (ctxt->myDoc)
+      xmlFreeDoc(ctxt->myDoc);
+    xmlFreeParserCtxt(ctxt);
+  }
+};
+
+// Create the libxml++ wrappers of node and its siblings, their attributes and all their descendants.
+void create_wrappers(xmlNode* node)
+{
+  for (; node; node = node->next)
+  {
+    xmlpp::Node::create_wrapper(node);
+    if (node->type == XML_ELEMENT_NODE)
+      for (xmlAttr* attribute = node->properties; attribute; attribute = attribute->next)
+        xmlpp::Node::create_wrapper(reinterpret_cast<xmlNode*>(attribute));
+    if (node->type != XML_ENTITY_REF_NODE)
+      create_wrappers(node->children);
+  }
+}
+
+} // namespace
+
+Reader::Reader() : m_frozen(false)
 {
-  m_parser.set_substitute_entities();
+}
+
+xmlpp::DomParser& Reader::parser()
+{
+  if (!m_parser)
+  {
+    m_parser = std::make_unique<xmlpp::DomParser>();
+    m_parser->set_substitute_entities();
+  }
+  return *m_parser;
 }
 
 void Reader::parse(std::istream& file, uint32_t version_major)
@@ -40,8 +214,11 @@ void Reader::parse(std::istream& file, uint32_t version_major)
   set_version(version_major);
   try
   {
-    m_parser.parse_stream(file);
-    if (!m_parser)
+    Tracer::Scope trace("Reader::parse");
+    MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+    xmlpp::DomParser& dom_parser = parser();
+    dom_parser.parse_stream(file);
+    if (!dom_parser)
     {
       THROW_ALERT("Failed to parse XML: unknown error.");
     }
@@ -50,30 +227,176 @@ void Reader::parse(std::istream& file, uint32_t version_major)
   {
     THROW_ALERT("Failed to parse XML: [WHAT]", AIArgs("[WHAT]", error.what()));
   }
-  m_root_element = m_parser.get_document()->get_root_node();
+  m_root_element = m_parser->get_document()->get_root_node();
+  m_owned_document.reset();
+  reset_state();
+  m_frozen = false;
 }
 
-void Reader::parse(fs::path const& filepath, uint32_t version_major)
+void Reader::parse_memory(std::string_view document, uint32_t version_major)
 {
-  fs::ifstream file;
+  set_version(version_major);
   try
   {
-    if (!exists(filepath))
+    Tracer::Scope trace("Reader::parse");
+    MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+    xmlpp::DomParser& dom_parser = parser();
+    dom_parser.parse_memory_raw(reinterpret_cast<unsigned char const*>(document.data()), document.size());
+    if (!dom_parser)
     {
-      using namespace boost::system;
-      throw fs::filesystem_error("", filepath, "", error_code(errc::no_such_file_or_directory, generic_category()));
+      THROW_ALERT("Failed to parse XML: unknown error.");
     }
-    file.open(filepath, std::ios_base::binary);
   }
-  catch (fs::filesystem_error const& ex)
+  catch (xmlpp::parse_error const& error)
+  {
+    THROW_ALERT("Failed to parse XML: [WHAT]", AIArgs("[WHAT]", error.what()));
+  }
+  m_root_element = m_parser->get_document()->get_root_node();
+  m_owned_document.reset();
+  reset_state();
+  m_frozen = false;
+}
+
+void Reader::parse(std::istream& file, uint32_t version_major, Projection const& projection)
+{
+  set_version(version_major);
+  Tracer::Scope trace("Reader::parse");
+  MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+  ProjectionFilter filter(projection);
+  xmlSAXHandler sax = filter.sax_handler();
+  std::unique_ptr<xmlParserCtxt, ParserCtxtDeleter> ctxt(xmlCreatePushParserCtxt(&sax, nullptr, nullptr, 0, nullptr));
+  if (!ctxt)
+  {
+    THROW_ALERT("Failed to parse XML: could not create parser context.");
+  }
+  xmlCtxtUseOptions(ctxt.get(), XML_PARSE_NOENT);
+  ctxt->_private = &filter;
+  char buffer[65536];
+  do
   {
-    THROW_ALERT("fs::open: [ERROR]", AIArgs("[ERROR]", ex.what()));
+    file.read(buffer, sizeof(buffer));
+    if (file.gcount() > 0 && xmlParseChunk(ctxt.get(), buffer, file.gcount(), 0) != 0)
+      break;
   }
+  while (file);
+  xmlParseChunk(ctxt.get(), nullptr, 0, 1);
+  if (!ctxt->wellFormed || !ctxt->myDoc)
+  {
+    xmlError const* error = xmlCtxtGetLastError(ctxt.get());
+    THROW_ALERT("Failed to parse XML: [WHAT]", AIArgs("[WHAT]", error && error->message ? error->message : "unknown error."));
+  }
+  // Hand the document over to a xmlpp::Document.
+  m_owned_document.reset(new xmlpp::Document(ctxt->myDoc));
+  ctxt->myDoc = nullptr;
+  m_root_element = m_owned_document->get_root_node();
+  reset_state();
+  m_frozen = false;
+}
+
+void Reader::parse(fs::path const& filepath, uint32_t version_major)
+{
+  parse_file(filepath, version_major, nullptr);
+}
+
+void Reader::parse(fs::path const& filepath, uint32_t version_major, Projection const& projection)
+{
+  parse_file(filepath, version_major, &projection);
+}
+
+void Reader::parse_file(fs::path const& filepath, uint32_t version_major, Projection const* projection)
+{
+  std::ifstream file;
+  open_file(file, filepath);
 
   std::cout << "Reading file " << filepath << "." << std::endl;
 
-  parse(file, version_major);
+  if (projection)
+    parse(file, version_major, *projection);
+  else
+    parse(file, version_major);
   file.close();
 }
 
+bool Reader::parse_parallel(fs::path const& filepath, uint32_t version_major, std::string_view parent_name, unsigned int threads)
+{
+  xmlDoc* doc;
+  {
+    Tracer::Scope trace("Reader::parse");
+    MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::parse);
+    doc = RecordSplitter(filepath).parse(parent_name, threads);
+  }
+  if (!doc)
+  {
+    parse(filepath, version_major);
+    return false;
+  }
+  set_version(version_major);
+  // Hand the document over to a xmlpp::Document.
+  m_owned_document.reset(new xmlpp::Document(doc));
+  m_root_element = m_owned_document->get_root_node();
+  reset_state();
+  m_frozen = false;
+  return true;
+}
+
+void Reader::release()
+{
+  Tracer::Scope trace("Reader::release");
+  m_root_element = nullptr;
+  m_owned_document.reset();
+  m_parser.reset();
+  reset_state();
+  m_frozen = false;
+}
+
+void Reader::freeze()
+{
+  Tracer::Scope trace("Reader::freeze");
+  // Call parse() before freeze().
+  ASSERT(m_root_element);
+  create_wrappers(const_cast<xmlNode*>(m_root_element->cobj()));
+  m_frozen = true;
+}
+
+ElementPath const& Reader::compiled_path(std::string_view path)
+{
+  auto compiled = m_path_cache.find(path);
+  if (compiled == m_path_cache.end())
+    compiled = m_path_cache.emplace(std::string(path), ElementPath(path)).first;
+  return compiled->second;
+}
+
+std::size_t Reader::read_matches(std::string_view path, std::function<bool()> const& read)
+{
+  ElementPath const& element_path = compiled_path(path);
+  xmlpp::Element const* const root_element = m_root_element;
+  std::size_t count = 0;
+  int const depth = Bridge::m_state.m_depth;
+  // Put the current state aside and start each match with a fresh state, as if the element were the root.
+  state_type saved_state;
+  m_state.swap(saved_state);
+  try
+  {
+    element_path.for_each_match(root_element, [&](xmlpp::Element const* element){
+      ++count;
+      state_type fresh_state;
+      m_state.swap(fresh_state);
+      m_root_element = element;
+      return read();
+    });
+  }
+  catch (...)
+  {
+    // Close the children that read() opened but did not close because it threw.
+    while (Bridge::m_state.m_depth > depth)
+      close_child();
+    m_root_element = root_element;
+    m_state.swap(saved_state);
+    throw;
+  }
+  m_root_element = root_element;
+  m_state.swap(saved_state);
+  return count;
+}
+
 } // namespace xml
@@ -27,9 +27,17 @@
 #pragma once
 
 #include "ReadBridge.h"
+#include "ElementPath.h"
+#include "Projection.h"
+#include "RecordIndex.h"
 
 #include <cinttypes>
+#include <functional>
 #include <iosfwd>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <thread>
 #include <boost/filesystem.hpp>
 #include <libxml++/libxml++.h>
 
@@ -38,7 +46,10 @@ namespace xml {
 class Reader : public ReadBridge
 {
   private:
-    xmlpp::DomParser m_parser;
+    std::unique_ptr<xmlpp::DomParser> m_parser;			// The parser of parse() and parse_memory(); null until used and after release().
+    std::unique_ptr<xmlpp::Document> m_owned_document;		// The document of the last parse that did not use m_parser.
+    std::map<std::string, ElementPath, std::less<>> m_path_cache;	// The compiled paths passed to read_at and read_each_at.
+    bool m_frozen;							// Set by freeze(), reset by parsing.
 
   public:
     /// Construct an empty XML parser.
@@ -49,6 +60,168 @@ class Reader : public ReadBridge
 
     /// Parse an XML file.
     void parse(boost::filesystem::path const& file, uint32_t version_major);
+
+    /// Parse the XML document \a document.
+    void parse_memory(std::string_view document, uint32_t version_major);
+
+    /**
+      * \brief Parse an XML file, dropping every element that is not in \a projection.
+      *
+      * Dropped subtrees are skipped by the parser; no DOM nodes are created for them.
+      * See Projection.
+      */
+    void parse(std::istream& file, uint32_t version_major, Projection const& projection);
+
+    /// Parse an XML file, dropping every element that is not in \a projection.
+    void parse(boost::filesystem::path const& file, uint32_t version_major, Projection const& projection);
+
+    /**
+      * \brief Parse an XML file, splitting the children of the element \a parent_name over \a threads threads.
+      *
+      * Meant for documents that consist mostly of one long list of records, for example
+      * the container that is read with children(). Each thread parses a byte range of the
+      * list; the records are then put back into the container in their original order,
+      * so that reading the document afterwards gives the same result as after parse().
+      *
+      * When the document cannot be split safely (see RecordSplitter) it is parsed sequentially.
+      *
+      * \returns True if the document was parsed in parallel.
+      */
+    bool parse_parallel(boost::filesystem::path const& file, uint32_t version_major, std::string_view parent_name,
+        unsigned int threads = std::thread::hardware_concurrency());
+
+    /**
+      * \brief Free each element that was read by children(), children_stream() or another sibling with the same name, as soon as the next one is read.
+      *
+      * The elements are unlinked from the document and freed, including all their
+      * descendants. Because parse() builds the whole DOM first, the peak memory is still
+      * at least the size of the whole DOM; this only keeps the DOM and the objects that
+      * were read from adding up, for example when reading a long list into a container.
+      * To bound the peak itself, use RecordReader or parse with a Projection.
+      * The document can then only be read once. Don't use this together with freeze().
+      */
+    void set_release_consumed(bool release) { m_release_consumed = release; }
+
+    /**
+      * \brief Free the parsed document.
+      *
+      * Call this after reading, when the document is no longer needed but the Reader is.
+      */
+    void release();
+
+    /**
+      * \brief Prepare the parsed document for concurrent reading with ReadCursor objects.
+      *
+      * Creates the libxml++ wrappers of all nodes, so that reading no longer modifies the document.
+      * Parsing a new document undoes this.
+      */
+    void freeze();
+
+    /// Return true if freeze() was called after the last parse.
+    bool frozen() const { return m_frozen; }
+
+    /// Return the root element of the parsed document.
+    xmlpp::Element const* root_element() const { return m_root_element; }
+
+    /**
+      * \brief Add the element names that are requested while reading to \a projection.
+      *
+      * Pass nullptr to stop learning. The Projection must outlive the learning.
+      */
+    void learn_projection(Projection* projection) { m_projection_learner = projection; }
+
+    /**
+      * \brief Read \a object from the parsed XML document.
+      *
+      * This is the same as calling object.xml(reader) directly,
+      * except that it is accounted as the deserialize phase when
+      * memory accounting is enabled and that the root element is
+      * included by the Profiler.
+      *
+      * \param object : An object of a class type that implements void xml(xml::Bridge&).
+      */
+    template<typename T>
+      void read(T& object);
+
+    /**
+      * \brief Read \a object from the first element that matches \a path.
+      *
+      * Only the matching element is deserialized, by calling object.xml(reader)
+      * as if that element were the root element. See ElementPath for the syntax of
+      * \a path; compiled paths are cached in the Reader.
+      * For example,
+      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+      * Product product;
+      * reader.read_at("/catalog/product[@product_image='cardigan.jpg']", product);
+      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+      *
+      * \returns True if a matching element was found.
+      */
+    template<typename T>
+      bool read_at(std::string_view path, T& object);
+
+    /**
+      * \brief Read every element that matches \a path and pass it to \a visitor.
+      *
+      * \param path : the elements to read; see ElementPath.
+      * \param visitor : a callable with a single parameter of the (non-deduced) element type, for example `[](Product&& product){ ... }`.
+      *
+      * \returns The number of matching elements.
+      */
+    template<typename VISITOR, typename = std::enable_if_t<is_visitor<VISITOR>>>
+      std::size_t read_each_at(std::string_view path, VISITOR&& visitor);
+
+    /**
+      * \brief Read \a object from record \a n of \a document, using \a index.
+      *
+      * Only the bytes of that record are read and parsed; the record becomes the parsed document.
+      * See RecordIndex.
+      */
+    template<typename T>
+      void read_record(std::istream& document, uint32_t version_major, RecordIndex const& index, std::size_t n, T& object);
+
+  private:
+    // Return m_parser, creating it if necessary.
+    xmlpp::DomParser& parser();
+    // Open filepath and call parse(file, version_major, projection), or the normal parse if projection is null.
+    void parse_file(boost::filesystem::path const& filepath, uint32_t version_major, Projection const* projection);
+    // Return the compiled version of path.
+    ElementPath const& compiled_path(std::string_view path);
+    // Call read() for every element that matches path, with that element temporarily being the root element, until read() returns false.
+    std::size_t read_matches(std::string_view path, std::function<bool()> const& read);
 };
 
+template<typename T>
+bool Reader::read_at(std::string_view path, T& object)
+{
+  return read_matches(path, [&object, this]{ object.xml(*this); return false; }) > 0;
+}
+
+template<typename VISITOR, typename>
+std::size_t Reader::read_each_at(std::string_view path, VISITOR&& visitor)
+{
+  return read_matches(path, [&visitor, this]{
+    visitor_element_type<VISITOR> object;
+    object.xml(*this);
+    call_visitor(visitor, object);
+    return true;
+  });
+}
+
+template<typename T>
+void Reader::read_record(std::istream& document, uint32_t version_major, RecordIndex const& index, std::size_t n, T& object)
+{
+  parse_memory(index.record(document, n), version_major);
+  read(object);
+}
+
+template<typename T>
+void Reader::read(T& object)
+{
+  Tracer::Scope trace("Reader::read");
+  MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::deserialize);
+  Profiler::Scope profile(m_profiler, true);
+  object.xml(*this);
+}
+
 } // namespace xml
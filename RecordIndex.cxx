@@ -0,0 +1,290 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class RecordIndex.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "RecordIndex.h"
+#include "MarkupScanner.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+#include <istream>
+
+namespace fs = boost::filesystem;
+
+namespace xml {
+
+namespace {
+
+char const index_magic[8] = { 'A', 'I', 'X', 'M', 'L', 'I', 'D', 'X' };
+uint32_t const index_format_version = 1;
+std::size_t const chunk_size = 1024 * 1024;
+
+// Integers are stored little-endian, independent of the host.
+template<typename T>
+void write_value(std::ostream& os, T value)
+{
+  char bytes[sizeof(T)];
+  for (std::size_t i = 0; i < sizeof(T); ++i)
+    bytes[i] = static_cast<char>(value >> (8 * i));
+  os.write(bytes, sizeof(bytes));
+}
+
+void write_string(std::ostream& os, std::string const& str)
+{
+  write_value<uint32_t>(os, str.size());
+  os.write(str.data(), str.size());
+}
+
+template<typename T>
+T read_value(std::istream& is)
+{
+  unsigned char bytes[sizeof(T)] = {};
+  is.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+  T value = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i)
+    value |= static_cast<T>(bytes[i]) << (8 * i);
+  return value;
+}
+
+// Return the number of bytes after the read position of is, which is a file of file_size bytes.
+uint64_t remaining(std::istream& is, uint64_t file_size)
+{
+  std::streamoff const pos = is.tellg();
+  return pos < 0 || static_cast<uint64_t>(pos) > file_size ? 0 : file_size - pos;
+}
+
+// Read a string from is, which is a file of file_size bytes; fails the stream when the length goes beyond the end of the file.
+std::string read_string(std::istream& is, uint64_t file_size)
+{
+  uint32_t len = read_value<uint32_t>(is);
+  std::string str;
+  if (is && len > remaining(is, file_size))
+    is.setstate(std::ios_base::failbit);
+  if (is)
+  {
+    str.resize(len);
+    is.read(str.data(), len);
+  }
+  return str;
+}
+
+} // namespace
+
+std::optional<std::size_t> RecordIndex::find(std::string const& key) const
+{
+  auto entry = m_key_map.find(key);
+  if (entry == m_key_map.end())
+    return std::nullopt;
+  return entry->second;
+}
+
+void RecordIndex::add(uint64_t offset)
+{
+  m_offsets.push_back(offset);
+  if (!m_key_attribute.empty())
+    m_keys.emplace_back();
+}
+
+void RecordIndex::set_key(std::string_view key)
+{
+  // Call add() first; records only have a key when a key attribute was given.
+  ASSERT(!m_keys.empty());
+  m_keys.back() = key;
+  m_key_map.emplace(m_keys.back(), m_keys.size() - 1);
+}
+
+void RecordIndex::append(RecordIndex const& index, uint64_t base)
+{
+  for (std::size_t n = 0; n < index.size(); ++n)
+  {
+    add(base + index.offset(n));
+    if (!m_key_attribute.empty() && !index.m_keys.empty())
+      set_key(index.key(n));
+  }
+}
+
+void RecordIndex::build(std::istream& document)
+{
+  m_offsets.clear();
+  m_keys.clear();
+  m_key_map.clear();
+  std::vector<std::string> open_elements;	// The names of the currently open elements.
+  std::string key;
+  std::vector<char> buffer(chunk_size);
+  std::size_t begin = 0;			// The start of the unscanned input in buffer.
+  std::size_t end = 0;				// The end of the input in buffer.
+  uint64_t offset = 0;				// The document offset of buffer[begin].
+  bool eof = false;
+  for (;;)
+  {
+    MarkupScanner::Token token = MarkupScanner::next(std::string_view(buffer.data() + begin, end - begin), eof);
+    if (token.m_type == MarkupScanner::incomplete)
+    {
+      if (eof)
+        break;
+      // Move the incomplete token to the front of the buffer, and grow the buffer if it is already full.
+      std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+      end -= begin;
+      begin = 0;
+      if (end == buffer.size())
+        buffer.resize(2 * buffer.size());
+      document.read(buffer.data() + end, buffer.size() - end);
+      end += document.gcount();
+      eof = document.gcount() == 0;
+      continue;
+    }
+    std::string_view const tag(buffer.data() + begin, token.m_length);
+    if (token.m_type == MarkupScanner::start_tag || token.m_type == MarkupScanner::empty_element_tag)
+    {
+      if (!open_elements.empty() && open_elements.back() == m_parent_name)
+      {
+        add(offset);
+        if (!m_key_attribute.empty() && MarkupScanner::attribute_value(tag, m_key_attribute, key))
+          set_key(key);
+      }
+      if (token.m_type == MarkupScanner::start_tag)
+        open_elements.emplace_back(MarkupScanner::tag_name(tag));
+    }
+    else if (token.m_type == MarkupScanner::end_tag && !open_elements.empty())
+      open_elements.pop_back();
+    begin += token.m_length;
+    offset += token.m_length;
+  }
+  if (document.bad())
+  {
+    THROW_ALERT("Failed to read the document to index.");
+  }
+  m_document_size = offset + (end - begin);
+}
+
+std::string RecordIndex::record(std::istream& document, std::size_t n) const
+{
+  if (n >= m_offsets.size())
+  {
+    THROW_ALERT("Record [N] does not exist; the index has [SIZE] records.", AIArgs("[N]", n)("[SIZE]", m_offsets.size()));
+  }
+  document.clear();
+  if (m_document_size)
+  {
+    document.seekg(0, std::ios_base::end);
+    if (static_cast<uint64_t>(document.tellg()) != m_document_size)
+    {
+      THROW_ALERT("The index does not match the document: the document has size [SIZE], expected [EXPECTED].",
+          AIArgs("[SIZE]", static_cast<uint64_t>(document.tellg()))("[EXPECTED]", m_document_size));
+    }
+  }
+  document.seekg(m_offsets[n]);
+  std::string bytes;
+  std::size_t scanned = 0;
+  int depth = 0;
+  bool eof = false;
+  for (;;)
+  {
+    MarkupScanner::Token token = MarkupScanner::next(std::string_view(bytes).substr(scanned), eof);
+    if (token.m_type == MarkupScanner::incomplete)
+    {
+      if (eof)
+      {
+        THROW_ALERT("The index does not match the document: record [N] at offset [OFFSET] is truncated.",
+            AIArgs("[N]", n)("[OFFSET]", m_offsets[n]));
+      }
+      std::size_t const size = bytes.size();
+      bytes.resize(size + 4096);
+      document.read(bytes.data() + size, 4096);
+      bytes.resize(size + document.gcount());
+      eof = document.gcount() == 0;
+      continue;
+    }
+    if (scanned == 0 && token.m_type != MarkupScanner::start_tag && token.m_type != MarkupScanner::empty_element_tag)
+    {
+      THROW_ALERT("The index does not match the document: there is no start tag at offset [OFFSET] (record [N]).",
+          AIArgs("[OFFSET]", m_offsets[n])("[N]", n));
+    }
+    if (token.m_type == MarkupScanner::start_tag)
+      ++depth;
+    else if (token.m_type == MarkupScanner::end_tag)
+      --depth;
+    scanned += token.m_length;
+    if (depth == 0)
+      break;
+  }
+  bytes.resize(scanned);
+  return bytes;
+}
+
+void RecordIndex::save(fs::path const& path) const
+{
+  fs::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+  file.write(index_magic, sizeof(index_magic));
+  write_value(file, index_format_version);
+  write_string(file, m_parent_name);
+  write_string(file, m_key_attribute);
+  write_value<uint64_t>(file, m_document_size);
+  write_value<uint64_t>(file, m_offsets.size());
+  for (std::size_t n = 0; n < m_offsets.size(); ++n)
+  {
+    write_value(file, m_offsets[n]);
+    if (!m_key_attribute.empty())
+      write_string(file, m_keys[n]);
+  }
+  file.close();
+  if (!file)
+  {
+    THROW_ALERT("Failed to write index file \"[FILE]\".", AIArgs("[FILE]", path.string()));
+  }
+}
+
+void RecordIndex::load(fs::path const& path)
+{
+  fs::ifstream file(path, std::ios_base::binary);
+  char magic[sizeof(index_magic)];
+  file.read(magic, sizeof(magic));
+  if (!file || std::memcmp(magic, index_magic, sizeof(magic)) != 0 || read_value<uint32_t>(file) != index_format_version)
+  {
+    THROW_ALERT("\"[FILE]\" is not a record index file.", AIArgs("[FILE]", path.string()));
+  }
+  uint64_t const file_size = fs::file_size(path);
+  std::string parent_name = read_string(file, file_size);
+  std::string key_attribute = read_string(file, file_size);
+  RecordIndex index(parent_name, key_attribute);
+  index.m_document_size = read_value<uint64_t>(file);
+  uint64_t const size = read_value<uint64_t>(file);
+  // Every record takes at least its offset; don't trust a count that doesn't fit in the file.
+  if (file && size > remaining(file, file_size) / sizeof(uint64_t))
+    file.setstate(std::ios_base::failbit);
+  for (uint64_t n = 0; n < size && file; ++n)
+  {
+    index.add(read_value<uint64_t>(file));
+    if (!index.m_key_attribute.empty())
+      index.set_key(read_string(file, file_size));
+  }
+  if (!file)
+  {
+    THROW_ALERT("Failed to read index file \"[FILE]\": truncated or corrupt.", AIArgs("[FILE]", path.string()));
+  }
+  *this = std::move(index);
+}
+
+} // namespace xml
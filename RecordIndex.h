@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class RecordIndex.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::RecordIndex
+ * \brief A persistent index of the byte offsets of the child elements ("records") of a given element.
+ *
+ * The index lists the offset of the start tag of every child element of
+ * elements with name parent_name(), in document order, and optionally the
+ * value of the attribute key_attribute() of each record.
+ *
+ * An index is created by scanning an existing document once with build()
+ * (see also the index_tool program), or while writing the document, at no
+ * extra cost, by passing it to WriteBridge::set_record_index. It can be
+ * stored with save() and loaded with load(). Reader::read_record then
+ * deserializes a single record without parsing anything else.
+ *
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::RecordIndex index;
+ * index.load("export.xml.idx");
+ * boost::filesystem::ifstream document("export.xml", std::ios_base::binary);
+ * Product product;
+ * reader.read_record(document, 1, index, 731902, product);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A record is parsed as a document of its own, so it may not use namespace
+ * prefixes or entities that are declared outside of it.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace xml {
+
+class RecordIndex
+{
+  private:
+    std::string m_parent_name;				// The name of the elements whose children are indexed.
+    std::string m_key_attribute;			// The name of the key attribute, or empty.
+    uint64_t m_document_size;				// The size of the indexed document, or zero when unknown.
+    std::vector<uint64_t> m_offsets;			// The offset of each record.
+    std::vector<std::string> m_keys;			// The key of each record, if m_key_attribute is not empty.
+    std::unordered_map<std::string, std::size_t> m_key_map;	// Maps keys to the (first) record with that key.
+
+  public:
+    /// Construct an empty index; use load() to read an index from disk.
+    RecordIndex() : m_document_size(0) { }
+
+    /// Construct an empty index for the children of elements with name \a parent_name, keyed by the attribute \a key_attribute (if not empty).
+    RecordIndex(std::string_view parent_name, std::string_view key_attribute = {}) :
+      m_parent_name(parent_name), m_key_attribute(key_attribute), m_document_size(0) { }
+
+    /// Return the name of the elements whose children are indexed.
+    std::string const& parent_name() const { return m_parent_name; }
+
+    /// Return the name of the key attribute, or an empty string if records have no key.
+    std::string const& key_attribute() const { return m_key_attribute; }
+
+    /// Return the number of records.
+    std::size_t size() const { return m_offsets.size(); }
+
+    /// Return the byte offset of the start tag of record \a n.
+    uint64_t offset(std::size_t n) const { return m_offsets[n]; }
+
+    /// Return the key of record \a n.
+    std::string const& key(std::size_t n) const { return m_keys[n]; }
+
+    /// Return the number of the first record with key \a key, if any.
+    std::optional<std::size_t> find(std::string const& key) const;
+
+    /// Return the size of the indexed document, or zero when unknown.
+    uint64_t document_size() const { return m_document_size; }
+
+    /// Add a record that starts at \a offset.
+    void add(uint64_t offset);
+
+    /// Set the key of the last added record.
+    void set_key(std::string_view key);
+
+    /// Add the records of \a index, with their offsets increased by \a base.
+    void append(RecordIndex const& index, uint64_t base);
+
+    /// Set the size of the indexed document.
+    void set_document_size(uint64_t document_size) { m_document_size = document_size; }
+
+    /// Replace the records with those of \a document, which is scanned once.
+    void build(std::istream& document);
+
+    /**
+      * \brief Return the bytes of record \a n of \a document.
+      *
+      * \throws AIAlert::Error when the index does not match the document.
+      */
+    std::string record(std::istream& document, std::size_t n) const;
+
+    /// Write the index to \a path, in a format that is independent of the byte order of the host.
+    void save(boost::filesystem::path const& path) const;
+
+    /// Read the index from \a path. Throws AIAlert::Error when the file is not an index file or is truncated or corrupt.
+    void load(boost::filesystem::path const& path);
+};
+
+} // namespace xml
@@ -0,0 +1,246 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class RecordReader.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "RecordReader.h"
+#include "MarkupScanner.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <istream>
+#include <unistd.h>
+
+namespace xml {
+
+namespace {
+
+// Errors are reported by the exception that next() throws, not on stderr.
+// A template, because the constness of the error parameter differs between libxml2 versions.
+template<typename ERROR>
+void ignore_error(void*, ERROR)
+{
+}
+
+bool is_space(char c)
+{
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// Return true if str only contains comments, processing instructions and whitespace.
+bool only_misc(std::string_view str)
+{
+  while (!str.empty())
+  {
+    MarkupScanner::Token token = MarkupScanner::next(str, true);
+    if (token.m_length == 0)
+      return false;
+    std::string_view const markup = str.substr(0, token.m_length);
+    if (token.m_type == MarkupScanner::text)
+    {
+      for (char c : markup)
+        if (!is_space(c))
+          return false;
+    }
+    else if (token.m_type != MarkupScanner::other || (markup.substr(0, 4) != "<!--" && markup.substr(0, 2) != "<?"))
+      return false;
+    str.remove_prefix(token.m_length);
+  }
+  return true;
+}
+
+// xmlCtxtReadMemory takes the size as an int.
+constexpr std::size_t max_record_size = INT_MAX;
+
+} // namespace
+
+RecordReader::RecordReader(std::istream& input, uint32_t version_major, std::size_t buffer_size) :
+  m_input(&input), m_fd(-1), m_version_major(version_major), m_buffer(std::max(buffer_size, std::size_t{4096})),
+  m_begin(0), m_scan(0), m_end(0), m_depth(0), m_seen_root(false), m_eof(false), m_ctxt(xmlNewParserCtxt()), m_records(0)
+{
+  if (!m_ctxt)
+  {
+    THROW_ALERT("Failed to create XML parser context.");
+  }
+  m_ctxt->sax->serror = &ignore_error;
+}
+
+RecordReader::RecordReader(int fd, uint32_t version_major, std::size_t buffer_size) :
+  m_input(nullptr), m_fd(fd), m_version_major(version_major), m_buffer(std::max(buffer_size, std::size_t{4096})),
+  m_begin(0), m_scan(0), m_end(0), m_depth(0), m_seen_root(false), m_eof(false), m_ctxt(xmlNewParserCtxt()), m_records(0)
+{
+  if (!m_ctxt)
+  {
+    THROW_ALERT("Failed to create XML parser context.");
+  }
+  m_ctxt->sax->serror = &ignore_error;
+}
+
+RecordReader::~RecordReader()
+{
+  // The document uses the dictionary of the parser context; free it first.
+  m_document.reset();
+  xmlFreeParserCtxt(m_ctxt);
+}
+
+bool RecordReader::fill()
+{
+  if (m_eof)
+    return false;
+  if (m_end == m_buffer.size())
+  {
+    if (m_begin > 0)
+    {
+      // Move the partial record to the front of the buffer.
+      std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+      m_scan -= m_begin;
+      m_end -= m_begin;
+      m_begin = 0;
+    }
+    else
+      m_buffer.resize(2 * m_buffer.size());
+  }
+  char* const data = m_buffer.data() + m_end;
+  std::size_t const space = m_buffer.size() - m_end;
+  std::size_t len;
+  if (m_input)
+  {
+    m_input->read(data, space);
+    len = m_input->gcount();
+    if (m_input->bad())
+    {
+      THROW_ALERT("Failed to read XML records: stream error.");
+    }
+  }
+  else
+  {
+    ssize_t rlen;
+    while ((rlen = ::read(m_fd, data, space)) == -1)
+    {
+      if (errno != EINTR)
+      {
+        THROW_ALERT("Failed to read XML records: [ERROR]", AIArgs("[ERROR]", std::strerror(errno)));
+      }
+    }
+    len = rlen;
+  }
+  m_end += len;
+  m_eof = len == 0;
+  return !m_eof;
+}
+
+bool RecordReader::scan()
+{
+  while (m_scan < m_end)
+  {
+    MarkupScanner::Token token = MarkupScanner::next(std::string_view(m_buffer.data() + m_scan, m_end - m_scan), m_eof);
+    switch (token.m_type)
+    {
+      case MarkupScanner::incomplete:
+        return false;
+      case MarkupScanner::start_tag:
+        ++m_depth;
+        m_seen_root = true;
+        break;
+      case MarkupScanner::end_tag:
+        --m_depth;
+        break;
+      case MarkupScanner::empty_element_tag:
+        m_seen_root = true;
+        break;
+      default:
+        break;
+    }
+    m_scan += token.m_length;
+    if (m_seen_root && m_depth == 0)
+      return true;
+  }
+  return false;
+}
+
+bool RecordReader::next()
+{
+  // Discard the previous record and skip the whitespace that follows it.
+  m_begin = m_scan;
+  m_depth = 0;
+  m_seen_root = false;
+  for (;;)
+  {
+    while (m_begin < m_end && is_space(m_buffer[m_begin]))
+      ++m_begin;
+    m_scan = m_begin;
+    if (m_begin < m_end)
+      break;
+    if (!fill())
+      return false;
+  }
+  while (!scan())
+  {
+    if (m_scan - m_begin > max_record_size)
+      break;
+    if (!fill())
+    {
+      // At the end of the input, scan() no longer waits for look-ahead.
+      if (scan())
+        break;
+      // Comments and processing instructions after the last record are not a record.
+      if (!m_seen_root && only_misc(std::string_view(m_buffer.data() + m_begin, m_end - m_begin)))
+      {
+        m_begin = m_scan = m_end;
+        return false;
+      }
+      THROW_ALERT("Record [RECORD]: unexpected end of input.", AIArgs("[RECORD]", m_records + 1));
+    }
+  }
+  if (m_scan - m_begin > max_record_size)
+  {
+    THROW_ALERT("Record [RECORD] is larger than [MAX] bytes.", AIArgs("[RECORD]", m_records + 1)("[MAX]", max_record_size));
+  }
+  parse_record();
+  return true;
+}
+
+void RecordReader::parse_record()
+{
+  m_root_element = nullptr;
+  m_document.reset();
+  xmlDoc* doc = xmlCtxtReadMemory(m_ctxt, m_buffer.data() + m_begin, m_scan - m_begin, nullptr, nullptr, XML_PARSE_NOENT);
+  if (!doc)
+  {
+    xmlError const* error = xmlCtxtGetLastError(m_ctxt);
+    THROW_ALERT("Record [RECORD]: failed to parse XML: [WHAT]",
+        AIArgs("[RECORD]", m_records + 1)("[WHAT]", error && error->message ? error->message : "unknown error."));
+  }
+  m_document.reset(new xmlpp::Document(doc));
+  m_root_element = m_document->get_root_node();
+  ++m_records;
+  Dout(dc::xmlparser, "Parsed record " << m_records << " (" << (m_scan - m_begin) << " bytes).");
+
+  reset_state();
+  set_version(m_version_major);
+}
+
+} // namespace xml
@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class RecordReader.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::RecordReader
+ * \brief Reads a stream of concatenated XML documents, one record at a time.
+ *
+ * The input is read into a single buffer. A MarkupScanner finds the
+ * end of the root element of each document, and the record is then parsed
+ * in place from that buffer. Bytes are only moved when a record straddles
+ * the end of the buffer. The libxml2 parser context, including its
+ * dictionary of element names, is reused for all records.
+ *
+ * Whitespace between documents is skipped. Each document may start with its
+ * own XML declaration. Comments or processing instructions after a root
+ * element are treated as the prologue of the next document, or ignored
+ * when no document follows. A record can not be larger than 2 GB.
+ *
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::RecordReader records(STDIN_FILENO, 1);
+ * Order order;
+ * while (records.read(order))
+ * {
+ *   process(order);
+ *   order.clear();         // children() appends to containers.
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+
+#pragma once
+
+#include "ReadBridge.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <libxml++/libxml++.h>
+
+struct _xmlParserCtxt;
+
+namespace xml {
+
+class RecordReader : public ReadBridge
+{
+  public:
+    static constexpr std::size_t default_buffer_size = 1024 * 1024;	///< The initial size of the input buffer.
+
+  private:
+    std::istream* m_input;				// The input stream, or null when reading from m_fd.
+    int m_fd;						// The input file descriptor, when m_input is null.
+    uint32_t m_version_major;				// The version passed to set_version() for every record.
+    std::vector<char> m_buffer;				// The input buffer.
+    std::size_t m_begin;				// The start of the current record in m_buffer.
+    std::size_t m_scan;					// The position up to which the current record has been scanned.
+    std::size_t m_end;					// The end of the data in m_buffer.
+    int m_depth;					// The element depth at m_scan.
+    bool m_seen_root;					// Set when the start tag of the root element was scanned.
+    bool m_eof;						// Set when the end of the input was reached.
+    _xmlParserCtxt* m_ctxt;				// The parser context that is reused for all records.
+    std::unique_ptr<xmlpp::Document> m_document;	// The document of the current record.
+    uint64_t m_records;					// The number of records read so far.
+
+  public:
+    /**
+      * \brief Read records from \a input.
+      *
+      * Note that a `std::istream` blocks until the buffer is full; use the file descriptor
+      * constructor for pipes when records must be processed as soon as they arrive.
+      */
+    RecordReader(std::istream& input, uint32_t version_major, std::size_t buffer_size = default_buffer_size);
+
+    /// Read records from file descriptor \a fd, which is not closed by the RecordReader.
+    RecordReader(int fd, uint32_t version_major, std::size_t buffer_size = default_buffer_size);
+
+    /// Destructor.
+    ~RecordReader();
+
+    /**
+      * \brief Parse the next record.
+      *
+      * \returns False at the end of the input.
+      * \throws AIAlert::Error when the record is not well-formed or the input ends in the middle of a record.
+      */
+    bool next();
+
+    /**
+      * \brief Parse the next record and read \a object from it.
+      *
+      * \a object is reused as is: containers that are read with children() are appended to.
+      *
+      * \returns False at the end of the input, in which case \a object is untouched.
+      */
+    template<typename T>
+      bool read(T& object);
+
+    /// Return the bytes of the current record.
+    std::string_view record() const { return std::string_view(m_buffer.data() + m_begin, m_scan - m_begin); }
+
+    /// Return the number of records read so far.
+    uint64_t records() const { return m_records; }
+
+  private:
+    // Read more input into m_buffer, moving or growing it when it is full. Returns false at the end of the input.
+    bool fill();
+    // Advance m_scan over the markup of the current record. Returns true when the end of the root element was reached.
+    bool scan();
+    // Parse the bytes [m_begin, m_scan) and reset the bridge state for reading it.
+    void parse_record();
+};
+
+template<typename T>
+bool RecordReader::read(T& object)
+{
+  if (!next())
+    return false;
+  Tracer::Scope trace("RecordReader::read");
+  object.xml(*this);
+  return true;
+}
+
+} // namespace xml
@@ -0,0 +1,313 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class RecordSplitter.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "RecordSplitter.h"
+#include "MarkupScanner.h"
+#include "Tracer.h"
+#include "debug.h"
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+#include <libxml/tree.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xml {
+
+namespace {
+
+// Errors cause a fall back to sequential parsing, which reports them; don't print them here.
+// A template, because the constness of the error parameter differs between libxml2 versions.
+template<typename ERROR>
+void ignore_error(void*, ERROR)
+{
+}
+
+// The parser options of all parts: names may not be stored in a per-document dictionary, because nodes are moved between documents.
+int const parse_options = XML_PARSE_NOENT | XML_PARSE_NODICT;
+
+struct DocDeleter
+{
+  void operator()(xmlDoc* doc) const { xmlFreeDoc(doc); }
+};
+using doc_ptr = std::unique_ptr<xmlDoc, DocDeleter>;
+
+// Parse wrapper_begin + content + wrapper_end with a push parser, without copying content first.
+doc_ptr parse_range(std::string const& wrapper_begin, std::string_view content, std::string const& wrapper_end)
+{
+  // The parser refuses chunks of more than 10 MB without XML_PARSE_HUGE.
+  std::size_t const max_chunk = 1024 * 1024;
+  xmlParserCtxtPtr ctxt = xmlCreatePushParserCtxt(nullptr, nullptr, nullptr, 0, nullptr);
+  if (!ctxt)
+    return nullptr;
+  ctxt->sax->serror = &ignore_error;
+  xmlCtxtUseOptions(ctxt, parse_options);
+  bool ok = xmlParseChunk(ctxt, wrapper_begin.data(), wrapper_begin.size(), 0) == 0;
+  while (ok && !content.empty())
+  {
+    std::size_t const len = std::min(content.size(), max_chunk);
+    ok = xmlParseChunk(ctxt, content.data(), len, 0) == 0;
+    content.remove_prefix(len);
+  }
+  ok = ok && xmlParseChunk(ctxt, wrapper_end.data(), wrapper_end.size(), 1) == 0 && ctxt->wellFormed;
+  doc_ptr doc(ctxt->myDoc);
+  ctxt->myDoc = nullptr;
+  xmlFreeParserCtxt(ctxt);
+  return ok ? std::move(doc) : nullptr;
+}
+
+// Return the first element with name name in document order below node (inclusive).
+xmlNode* find_element(xmlNode* node, char const* name)
+{
+  for (; node; node = node->next)
+  {
+    if (node->type != XML_ELEMENT_NODE)
+      continue;
+    if (std::strcmp(reinterpret_cast<char const*>(node->name), name) == 0)
+      return node;
+    if (xmlNode* found = find_element(node->children, name))
+      return found;
+  }
+  return nullptr;
+}
+
+bool is_name_end(char c)
+{
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '>' || c == '/';
+}
+
+std::size_t count_lines(std::string_view text)
+{
+  return std::count(text.begin(), text.end(), '\n');
+}
+
+// Add delta to the line numbers of node, its siblings and all their descendants.
+// Like libxml2 does while parsing, line numbers that don't fit are stored as USHRT_MAX.
+void offset_lines(xmlNode* node, std::size_t delta)
+{
+  for (; node; node = node->next)
+  {
+    if (node->line != 0 && node->line != USHRT_MAX)
+      node->line = std::min<std::size_t>(node->line + delta, USHRT_MAX);
+    if (node->type == XML_ELEMENT_NODE)
+      offset_lines(node->children, delta);
+  }
+}
+
+} // namespace
+
+RecordSplitter::RecordSplitter(boost::filesystem::path const& file) : m_data(nullptr), m_size(0), m_content_begin(0), m_content_end(0)
+{
+  int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd != -1 && ::fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+      m_data = static_cast<char const*>(data);
+      m_size = st.st_size;
+      m_document = std::string_view(m_data, m_size);
+    }
+  }
+  if (fd != -1)
+    ::close(fd);
+}
+
+RecordSplitter::~RecordSplitter()
+{
+  if (m_data)
+    ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+bool RecordSplitter::split(std::string_view parent_name, unsigned int threads)
+{
+  if (!m_data)
+    return fail("the file could not be mapped");
+
+  // Each range is parsed with the XML declaration of the document, so that it is decoded the same way.
+  // Only encodings in which markup is plain ASCII can be split at byte offsets.
+  std::size_t pos = 0;
+  if (m_document.compare(0, 2, "\xFE\xFF") == 0 || m_document.compare(0, 2, "\xFF\xFE") == 0)
+    return fail("the document is encoded in UTF-16");
+  if (m_document.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    pos = 3;
+  if (m_document.compare(pos, 5, "<?xml") == 0 && m_document.size() > pos + 5 && is_name_end(m_document[pos + 5]))
+  {
+    std::size_t const end = m_document.find("?>", pos);
+    if (end == std::string_view::npos)
+      return fail("the XML declaration is not terminated");
+    m_declaration = m_document.substr(pos, end + 2 - pos);
+  }
+
+  // Find the start tag of the parent element, and the start tag of the first record in it.
+  std::string_view record_name;
+  while (record_name.empty())
+  {
+    MarkupScanner::Token token = MarkupScanner::next(m_document.substr(pos), true);
+    if (token.m_type == MarkupScanner::incomplete)
+      return fail("there is no element <" + std::string(parent_name) + "> with children");
+    std::string_view const tag = m_document.substr(pos, token.m_length);
+    if (tag.compare(0, 2, "<!") == 0 && tag.compare(0, 4, "<!--") != 0 && tag.compare(0, 9, "<![CDATA[") != 0)
+      return fail("the document has a DOCTYPE declaration");
+    if (token.m_type == MarkupScanner::start_tag || token.m_type == MarkupScanner::empty_element_tag)
+    {
+      if (tag.find("xmlns") != std::string_view::npos)
+        return fail("the document declares namespaces");
+      if (m_content_begin)
+        record_name = MarkupScanner::tag_name(tag);
+      else if (token.m_type == MarkupScanner::start_tag && MarkupScanner::tag_name(tag) == parent_name)
+        m_content_begin = pos + token.m_length;
+    }
+    else if (token.m_type == MarkupScanner::end_tag && m_content_begin)
+      return fail("element <" + std::string(parent_name) + "> has no children");
+    pos += token.m_length;
+  }
+
+  // The content ends at the last end tag of the parent element; if that isn't the matching one, a range will fail to parse.
+  std::string const end_tag = "</" + std::string(parent_name);
+  m_content_end = m_document.rfind(end_tag);
+  if (m_content_end == std::string_view::npos || m_content_end < pos)
+    return fail("the end tag of <" + std::string(parent_name) + "> was not found");
+
+  // Split at the first record start tag after each of threads equidistant points.
+  std::size_t const first_record = m_document.rfind('<', pos - 1);
+  std::size_t const content_size = m_content_end - first_record;
+  std::size_t const ranges = std::min<std::size_t>(threads, content_size / min_range_size);
+  if (ranges < 2)
+    return fail("the content of <" + std::string(parent_name) + "> is too small to split");
+  std::string const start_tag = "<" + std::string(record_name);
+  m_splits.assign(1, first_record);
+  for (std::size_t r = 1; r < ranges; ++r)
+  {
+    std::size_t split = std::max(first_record + content_size * r / ranges, m_splits.back() + 1);
+    while ((split = m_document.find(start_tag, split)) < m_content_end && !is_name_end(m_document[split + start_tag.size()]))
+      ++split;
+    if (split >= m_content_end)
+      break;
+    m_splits.push_back(split);
+  }
+  if (m_splits.size() < 2)
+    return fail("no record start tags were found to split at");
+  return true;
+}
+
+xmlDoc* RecordSplitter::parse(std::string_view parent_name, unsigned int threads)
+{
+  Tracer::Scope trace("RecordSplitter::parse");
+  if (!split(parent_name, threads))
+  {
+    Dout(dc::xmlparser, "Not parsing in parallel: " << m_failure << ".");
+    return nullptr;
+  }
+
+  std::string const wrapper_begin = std::string(m_declaration) + "<" + std::string(parent_name) + ">";
+  std::string const wrapper_end = "</" + std::string(parent_name) + ">";
+  std::size_t const ranges = m_splits.size();
+  std::vector<doc_ptr> parts(ranges);
+  std::vector<std::size_t> lines(ranges);		// The number of lines in each range.
+  auto parse_part = [&](std::size_t r){
+    Tracer::Scope trace("RecordSplitter::parse_range");
+    std::size_t const end = r + 1 < ranges ? m_splits[r + 1] : m_content_end;
+    std::string_view const content = m_document.substr(m_splits[r], end - m_splits[r]);
+    parts[r] = parse_range(wrapper_begin, content, wrapper_end);
+    lines[r] = count_lines(content);
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(ranges - 1);
+  try
+  {
+    for (std::size_t r = 1; r < ranges; ++r)
+      workers.emplace_back(parse_part, r);
+  }
+  catch (...)
+  {
+    // Failed to start a thread; the threads that were started must be joined before they are destructed.
+    for (std::thread& worker : workers)
+      worker.join();
+    throw;
+  }
+  parse_part(0);
+
+  // Parse the skeleton: everything except the records.
+  doc_ptr skeleton;
+  {
+    Tracer::Scope trace("RecordSplitter::parse_skeleton");
+    std::string_view const head = m_document.substr(0, m_splits[0]);
+    std::string_view const tail = m_document.substr(m_content_end);
+    std::string text;
+    text.reserve(head.size() + tail.size());
+    text.append(head).append(tail);
+    skeleton = parse_range(std::string(), text, std::string());
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+
+  xmlNode* const parent = skeleton ? find_element(xmlDocGetRootElement(skeleton.get()), std::string(parent_name).c_str()) : nullptr;
+  if (!parent)
+  {
+    fail("the document outside of the records did not parse");
+    Dout(dc::xmlparser, "Not parsing in parallel: " << m_failure << ".");
+    return nullptr;
+  }
+  for (std::size_t r = 0; r < ranges; ++r)
+    if (!parts[r])
+    {
+      fail("range " + std::to_string(r) + " did not parse");
+      Dout(dc::xmlparser, "Not parsing in parallel: " << m_failure << ".");
+      return nullptr;
+    }
+
+  // Move the records into the parent element of the skeleton, in order.
+  // The line numbers of each part count from the start of its range; make them count from the start of the file.
+  Tracer::Scope trace_merge("RecordSplitter::merge");
+  std::size_t lines_before_range = count_lines(m_document.substr(0, m_splits[0]));
+  std::size_t const wrapper_lines = count_lines(wrapper_begin);
+  for (std::size_t r = 0; r < ranges; ++r)
+  {
+    xmlNode* wrapper = xmlDocGetRootElement(parts[r].get());
+    xmlNode* children = wrapper->children;
+    std::size_t const delta = lines_before_range - wrapper_lines;
+    lines_before_range += lines[r];
+    if (!children)
+      continue;
+    if (delta > 0)
+      offset_lines(children, delta);
+    wrapper->children = wrapper->last = nullptr;
+    for (xmlNode* child = children; child; child = child->next)
+      child->parent = nullptr;
+    xmlAddChildList(parent, children);
+  }
+  Dout(dc::xmlparser, "Parsed the children of <" << parent_name << "> in " << ranges << " ranges.");
+  return skeleton.release();
+}
+
+} // namespace xml
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class RecordSplitter.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * \class xml::RecordSplitter
+ * \brief Parses a document with one large list of records using multiple threads.
+ *
+ * The file is mapped into memory and the content of the first element with
+ * the given parent name is split into one byte range per thread. Each range
+ * starts at a start tag with the name of the first record. Each thread parses
+ * its range, wrapped in an element with the parent name, into its own
+ * document. Meanwhile the calling thread parses the rest of the file (the
+ * "skeleton"). Finally the records are moved, in order, into the parent
+ * element of the skeleton.
+ *
+ * Every range is parsed with the XML declaration of the document, so that
+ * it is decoded with the same encoding, and the line numbers of the records
+ * are made relative to the start of the file. Documents in UTF-16 are not
+ * split.
+ *
+ * A split point may land on something that only looks like a record start
+ * tag, for example inside a comment or CDATA section. The range before it
+ * then ends inside unterminated markup and fails to parse. Therefore a
+ * split is only used when every range parses. In all other cases parse()
+ * returns null and the caller parses sequentially. That includes documents
+ * that declare namespaces or entities the records may depend on.
+ *
+ * Used by Reader::parse_parallel.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+struct _xmlDoc;
+
+namespace xml {
+
+class RecordSplitter
+{
+  public:
+    static constexpr std::size_t min_range_size = 1024 * 1024;	///< Ranges are not made smaller than this.
+
+  private:
+    char const* m_data;			// The mapped file, or null if it could not be mapped.
+    std::size_t m_size;			// The size of the file.
+    std::string_view m_document;	// The mapped file as string_view.
+    std::string_view m_declaration;	// The XML declaration of the document, or empty if there is none.
+    std::size_t m_content_begin;	// The start of the content of the parent element.
+    std::size_t m_content_end;		// The start of the end tag of the parent element.
+    std::vector<std::size_t> m_splits;	// The start of each range; the last range ends at m_content_end.
+    std::string m_failure;		// Why the document was not split.
+
+  public:
+    /// Map \a file into memory.
+    RecordSplitter(boost::filesystem::path const& file);
+
+    /// Unmap the file.
+    ~RecordSplitter();
+
+    RecordSplitter(RecordSplitter const&) = delete;
+    RecordSplitter& operator=(RecordSplitter const&) = delete;
+
+    /**
+      * \brief Parse the document, splitting the children of the first element with name \a parent_name over \a threads threads.
+      *
+      * \returns The parsed document, owned by the caller, or null if the document could not be split safely (see failure()).
+      */
+    _xmlDoc* parse(std::string_view parent_name, unsigned int threads);
+
+    /// Return why parse() returned null.
+    std::string const& failure() const { return m_failure; }
+
+  private:
+    // Find the content of the parent element and the split points; returns false (after setting m_failure) if that is not possible.
+    bool split(std::string_view parent_name, unsigned int threads);
+    // Set m_failure to what and return false.
+    bool fail(std::string what) { m_failure = std::move(what); return false; }
+};
+
+} // namespace xml
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class StringSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "StringSink.h"
+#include <algorithm>
+
+namespace xml {
+
+StringSink::StringSink(std::string& str) : m_string(str), m_initial_size(str.size())
+{
+  // m_begin is kept at the end of the original contents, so that bytes_written() counts only what we append.
+  m_begin = m_pos = m_end = m_string.data() + m_initial_size;
+}
+
+StringSink::~StringSink()
+{
+  sync();
+}
+
+void StringSink::overflow(std::size_t needed)
+{
+  std::size_t size = m_pos - m_string.data();
+  m_string.resize(std::max(2 * m_string.size(), size + std::max(needed, max_reserve)));
+  m_begin = m_string.data() + m_initial_size;
+  m_pos = m_string.data() + size;
+  m_end = m_string.data() + m_string.size();
+}
+
+void StringSink::sync()
+{
+  std::size_t size = m_pos - m_string.data();
+  m_string.resize(size);
+  m_begin = m_string.data() + m_initial_size;
+  m_pos = m_end = m_string.data() + size;
+}
+
+} // namespace xml
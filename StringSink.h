@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class StringSink.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::StringSink
+ * \brief An OutputSink that appends to a `std::string`.
+ *
+ * The string itself is used as output buffer, so no data is copied twice.
+ * While writing, the string is larger than the data written to it;
+ * its contents are only valid after a call to flush() (or destruction
+ * of the StringSink).
+ */
+
+#pragma once
+
+#include "OutputSink.h"
+
+namespace xml {
+
+class StringSink : public OutputSink
+{
+  private:
+    std::string& m_string;
+    std::size_t m_initial_size;		///< The size of m_string upon construction.
+
+  public:
+    /// Construct a StringSink that appends to \a str.
+    StringSink(std::string& str);
+
+    /// Truncate the string to the data written.
+    ~StringSink() override;
+
+  protected:
+    void overflow(std::size_t needed) override;
+    void sync() override;
+};
+
+} // namespace xml
@@ -0,0 +1,250 @@
+/**
+ * @file
+ * @brief This file contains the implementation of class Tracer.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sys.h"
+#include "Tracer.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+namespace xml {
+
+std::atomic<bool> Tracer::s_enabled;
+std::atomic<int> Tracer::s_max_depth;
+
+namespace {
+
+struct TraceEvent
+{
+  char const* m_name;
+  uint64_t m_timestamp;			// Nanoseconds of std::chrono::steady_clock.
+  char m_phase;				// 'B' or 'E'.
+};
+
+// A single producer ring buffer with the events of one thread.
+class TraceRing
+{
+  private:
+    std::unique_ptr<TraceEvent[]> m_events;
+    std::size_t m_mask;
+    std::atomic<uint64_t> m_head;	// The total number of events recorded.
+    int m_tid;
+
+  public:
+    TraceRing(std::size_t capacity, int tid) : m_events(new TraceEvent[capacity]), m_mask(capacity - 1), m_head(0), m_tid(tid) { }
+
+    void record(char const* name, char phase)
+    {
+      uint64_t head = m_head.load(std::memory_order_relaxed);
+      uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      m_events[head & m_mask] = { name, timestamp, phase };
+      m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void clear() { m_head.store(0, std::memory_order_relaxed); }
+
+    bool empty() const { return m_head.load(std::memory_order_relaxed) == 0; }
+
+    // Prepare a ring of a thread that exited for use by another thread.
+    void reset(std::size_t capacity)
+    {
+      if (capacity != m_mask + 1)
+      {
+        m_events.reset(new TraceEvent[capacity]);
+        m_mask = capacity - 1;
+      }
+      clear();
+    }
+
+    template<typename F>
+    void for_each(F const& f) const
+    {
+      uint64_t head = m_head.load(std::memory_order_acquire);
+      uint64_t first = head > m_mask ? head - m_mask - 1 : 0;
+      for (uint64_t i = first; i < head; ++i)
+        f(m_events[i & m_mask]);
+    }
+
+    int tid() const { return m_tid; }
+};
+
+// All rings, in the order of creation. The ring of a thread that exits is kept, so that its
+// events can still be exported, and is handed to a new thread once those events were exported
+// or cleared. Hence the number of rings is bounded by the number of threads that record events
+// at the same time plus max_retired_rings.
+std::mutex s_rings_mutex;
+std::vector<std::unique_ptr<TraceRing>> s_rings;
+std::deque<TraceRing*> s_retired_rings;		// Rings of exited threads with events that weren't exported yet, oldest first.
+std::vector<TraceRing*> s_free_rings;		// Rings of exited threads without events.
+std::size_t s_ring_capacity = 65536;
+constexpr std::size_t max_retired_rings = 64;
+
+// Move the rings of exited threads to the free list. Must be called with s_rings_mutex locked.
+void free_retired_rings()
+{
+  s_free_rings.insert(s_free_rings.end(), s_retired_rings.begin(), s_retired_rings.end());
+  s_retired_rings.clear();
+}
+
+// Owns the ring of the current thread and retires it when the thread exits.
+struct RingOwner
+{
+  TraceRing* m_ring = nullptr;
+
+  ~RingOwner()
+  {
+    if (!m_ring)
+      return;
+    std::lock_guard<std::mutex> lock(s_rings_mutex);
+    if (m_ring->empty())
+      s_free_rings.push_back(m_ring);
+    else
+      s_retired_rings.push_back(m_ring);
+  }
+};
+
+thread_local RingOwner t_ring_owner;
+
+TraceRing& ring()
+{
+  TraceRing* ring = t_ring_owner.m_ring;
+  if (!ring)
+  {
+    std::lock_guard<std::mutex> lock(s_rings_mutex);
+    if (!s_free_rings.empty())
+    {
+      ring = s_free_rings.back();
+      s_free_rings.pop_back();
+    }
+    else if (s_retired_rings.size() >= max_retired_rings)
+    {
+      // Too many exited threads with events that weren't exported; discard those of the thread that exited first.
+      ring = s_retired_rings.front();
+      s_retired_rings.pop_front();
+    }
+    else
+    {
+      s_rings.push_back(std::make_unique<TraceRing>(s_ring_capacity, static_cast<int>(s_rings.size()) + 1));
+      ring = s_rings.back().get();
+    }
+    ring->reset(s_ring_capacity);
+    t_ring_owner.m_ring = ring;
+  }
+  return *ring;
+}
+
+void write_json_string(std::ostream& os, char const* str)
+{
+  os << '"';
+  for (; *str; ++str)
+  {
+    unsigned char c = *str;
+    if (c == '"' || c == '\\')
+      os << '\\' << c;
+    else if (c < 0x20)
+      os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+    else
+      os << c;
+  }
+  os << '"';
+}
+
+} // namespace
+
+//static
+void Tracer::enable(int max_depth, std::size_t ring_capacity)
+{
+  {
+    std::lock_guard<std::mutex> lock(s_rings_mutex);
+    s_ring_capacity = 1;
+    while (s_ring_capacity < ring_capacity)
+      s_ring_capacity *= 2;
+  }
+  s_max_depth.store(max_depth, std::memory_order_relaxed);
+  s_enabled.store(true, std::memory_order_relaxed);
+}
+
+//static
+void Tracer::begin(char const* name)
+{
+  ring().record(name, 'B');
+}
+
+//static
+void Tracer::end(char const* name)
+{
+  ring().record(name, 'E');
+}
+
+//static
+void Tracer::clear()
+{
+  std::lock_guard<std::mutex> lock(s_rings_mutex);
+  for (auto& ring : s_rings)
+    ring->clear();
+  free_retired_rings();
+}
+
+//static
+void Tracer::write_json(std::ostream& os)
+{
+  std::lock_guard<std::mutex> lock(s_rings_mutex);
+  int const pid = ::getpid();
+  os << "{\"traceEvents\":[";
+  char const* separator = "\n";
+  for (auto const& ring : s_rings)
+  {
+    os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << ring->tid() <<
+      ",\"args\":{\"name\":\"thread " << ring->tid() << "\"}}";
+    separator = ",\n";
+    int depth = 0;
+    ring->for_each([&](TraceEvent const& event){
+      // Skip the end events of which the begin event was overwritten, so that the events stay balanced.
+      if (event.m_phase == 'B')
+        ++depth;
+      else if (depth == 0)
+        return;
+      else
+        --depth;
+      os << separator << "{\"name\":";
+      write_json_string(os, event.m_name);
+      // Timestamps are in microseconds.
+      os << ",\"cat\":\"xml\",\"ph\":\"" << event.m_phase << "\",\"ts\":" << event.m_timestamp / 1000 << '.' <<
+        std::setw(3) << std::setfill('0') << event.m_timestamp % 1000 << std::setfill(' ') <<
+        ",\"pid\":" << pid << ",\"tid\":" << ring->tid() << '}';
+    });
+  }
+  os << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+  // The events of threads that exited were exported; their rings can now be reused.
+  for (TraceRing* ring : s_retired_rings)
+    ring->clear();
+  free_retired_rings();
+}
+
+} // namespace xml
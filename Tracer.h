@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief This file contains the declaration of class Tracer.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * \class xml::Tracer
+ * \brief Records begin/end events of reading and writing for export as a Chrome trace.
+ *
+ * When enabled, Reader::parse, Reader::read, Writer::write and every
+ * children() block whose depth is less than the configured maximum record
+ * a begin and an end event with a timestamp. Every thread records into its
+ * own ring buffer without locking; when a ring buffer is full the oldest
+ * events are overwritten (the export then skips the end events of which the
+ * begin event was overwritten). The ring buffer of a thread that exits is reused
+ * by a later thread once its events were exported or cleared; the events of
+ * at most 64 exited threads are kept until then, beyond that the events of
+ * the thread that exited first are discarded. The events of all threads can
+ * be exported in the Chrome trace-event JSON format, which can be loaded in
+ * chrome://tracing or https://ui.perfetto.dev.
+ * For example,
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * xml::Tracer::enable(3);
+ * ...	// Read and write documents in any number of threads.
+ * std::ofstream trace("trace.json");
+ * xml::Tracer::write_json(trace);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Event names are stored as pointers, so the names passed to children()
+ * must remain valid until the export (string literals are fine).
+ * Export (and clear) while no other thread is recording events.
+ * When disabled, the overhead is a relaxed atomic load per hook.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+
+namespace xml {
+
+class Tracer
+{
+  private:
+    static std::atomic<bool> s_enabled;
+    static std::atomic<int> s_max_depth;
+
+  public:
+    /**
+      * \brief Start recording events.
+      *
+      * \param max_depth : children() blocks are only recorded when their depth (the number of enclosing elements) is less than this.
+      * \param ring_capacity : the number of events that each thread can hold; rounded up to a power of two.
+      *
+      * \a ring_capacity only affects threads that did not record any events yet.
+      */
+    static void enable(int max_depth = 2, std::size_t ring_capacity = 65536);
+
+    /// Stop recording events. Events recorded so far are kept.
+    static void disable() { s_enabled.store(false, std::memory_order_relaxed); }
+
+    /// Return true if events are being recorded.
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /// Discard all recorded events.
+    static void clear();
+
+    /// Write all recorded events to \a os as Chrome trace-event JSON. Afterwards the events of threads that exited are discarded.
+    static void write_json(std::ostream& os);
+
+    /// Record a begin event of \a name in the calling thread.
+    static void begin(char const* name);
+
+    /// Record an end event of \a name in the calling thread.
+    static void end(char const* name);
+
+    /// Records a begin event upon construction and the corresponding end event upon destruction.
+    class Scope
+    {
+      private:
+        char const* m_name;		// Null if nothing was recorded.
+
+      public:
+        /// Record a begin event of \a name, if tracing is enabled.
+        Scope(char const* name) : m_name(enabled() ? name : nullptr) { if (m_name) begin(m_name); }
+        /// Record a begin event of \a name, if tracing is enabled and \a depth is less than the maximum depth.
+        Scope(char const* name, int depth) :
+          m_name(enabled() && depth < s_max_depth.load(std::memory_order_relaxed) ? name : nullptr) { if (m_name) begin(m_name); }
+        /// Record the end event.
+        ~Scope() { if (m_name) end(m_name); }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    };
+};
+
+} // namespace xml
@@ -24,50 +24,69 @@
 #include "sys.h"
 #include "utils/AIAlert.h"
 #include "WriteBridge.h"
+#include "StringSink.h"
+#include "RecordIndex.h"
 #include "escape.h"
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace xml {
 
-WriteBridge::WriteBridge(std::ostream& os, uint32_t version_major) : Bridge(version_major), m_os(os), m_state(closed)
+WriteBridge::WriteBridge(OutputSink& sink, uint32_t version_major, Format const& format) :
+  Bridge(version_major), m_sink(sink), m_record_index(nullptr), m_state(closed), m_format(format), m_parallel_threads(1), m_parallel_min_elements(0),
+  m_record_key_pending(false)
+{
+}
+
+WriteBridge::WriteBridge(OutputSink& sink, WriteBridge const& parent) :
+  Bridge(parent.version()), m_sink(sink), m_record_index(nullptr), m_state(parent.m_state), m_format(parent.m_format), m_whitespace(parent.m_whitespace),
+  m_parallel_threads(1), m_parallel_min_elements(0), m_record_key_pending(false)
+{
+  Bridge::m_state = parent.Bridge::m_state;
+  m_root_depth = parent.m_root_depth;
+  // The state of the element that contains the container, so that index_record() sees the name of the parent.
+  if (!parent.m_state_stack.empty())
+    m_state_stack.push(parent.m_state_stack.top());
+}
+
+WriteBridge::~WriteBridge()
 {
 }
 
 void WriteBridge::node_name(char const* name)
 {
   DoutEntering(dc::xmlparser, "WriteBridge::node_name(\"" << name << "\")");
-  ASSERT(m_state.m_indentation >= 0);	// Call open_child() / close_child() around calling 'root.xml(parser)' for the root object.
-  m_state.close_child(m_os);
+  ASSERT(m_state.m_level >= 0);		// Call open_child() / close_child() around calling 'root.xml(parser)' for the root object.
+  m_state.close_child(m_sink, m_whitespace);
   if (m_state.m_parent_tag_state == half_open)
   {
-    m_os << ">\n";
-    if (!m_os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	  AIArgs("[DATA]", ">\\n"));
-    }
+    m_sink.append(">\n", 1 + m_state.m_eol);
     m_state.m_parent_tag_state = open;
   }
+  profile_element(name);
   m_state.m_element_name = name;
-  m_os << std::string(m_state.m_indentation, ' ') << '<' << m_state.m_element_name;
-  if (!m_os.good())
-  {
-    THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	AIArgs("[DATA]", "<" + m_state.m_element_name));
-  }
+  m_sink.append(m_whitespace.data(), m_state.m_indent);
+  if (m_record_index)
+    index_record();
+  m_sink.put('<');
+  m_sink.append(m_state.m_element_name);
   m_state.m_element_tag_state = half_open;
 }
 
 void WriteBridge::attribute(char const* name, char const* value)
 {
   DoutEntering(dc::xmlparser, "WriteBridge::attribute(\"" << name << "\", \"" << value << "\")");
-  std::string escaped_value = escape(value);
-  m_os << ' ' << name << "=\"" << escaped_value << '"';
-  if (!m_os.good())
-  {
-    THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	AIArgs("[DATA]", std::string(" ") + name + "=\"" + escaped_value + "\""));
-  }
+  m_sink.put(' ');
+  m_sink.append(name, std::strlen(name));
+  m_sink.append("=\"", 2);
+  escape_attribute(m_sink, value);
+  m_sink.put('"');
+  if (m_record_key_pending)
+    index_key(name, value);
 }
 
 void WriteBridge::child(char const* name, char const* value)
@@ -86,7 +105,16 @@ void WriteBridge::open_child()
   m_state_stack.push(m_state);
   m_state.m_parent_tag_state = m_state.m_element_tag_state;
   m_state.m_element_tag_state = closed;
-  m_state.m_indentation += 2;
+  // Calculate the whitespace of the new level here, so that writing the tags doesn't need to test anything.
+  int const level = ++m_state.m_level;
+  bool const pretty = level < m_format.m_pretty_depth;
+  bool const pretty_children = level + 1 < m_format.m_pretty_depth;
+  int const indentation = level * m_format.m_indentation;
+  m_state.m_indent = pretty ? indentation : 0;
+  m_state.m_end_indent = pretty_children ? indentation : 0;
+  m_state.m_eol = pretty ? 1 : 0;
+  if (m_state.m_indent > static_cast<int>(m_whitespace.size()))
+    m_whitespace.resize(2 * m_state.m_indent, m_format.m_indent_char);
 }
 
 void WriteBridge::open_child(char const* name)
@@ -99,75 +127,88 @@ void WriteBridge::open_child(char const* name)
 
 std::ostream& WriteBridge::get_os()
 {
-  return m_os;
+  if (!m_os)
+  {
+    m_streambuf.reset(new OutputSink::Streambuf(m_sink));
+    m_os.reset(new std::ostream(m_streambuf.get()));
+    // Append to the sink after every output operation, because the tags are written to the sink directly.
+    *m_os << std::unitbuf;
+  }
+  return *m_os;
 }
 
 void WriteBridge::write_child_stream(std::string const& element)
 {
   DoutEntering(dc::xmlparser, "WriteBridge::write_child_stream(\"" << element << "\")");
+  profile_element(m_state.m_element_name);
   if (m_state.m_parent_tag_state == half_open)
   {
     ASSERT(m_state.m_element_tag_state == closed);
-    m_os << ">\n";
-    if (!m_os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	  AIArgs("[DATA]", ">\\n"));
-    }
+    m_sink.append(">\n", 1 + m_state.m_eol);
     m_state.m_parent_tag_state = open;
   }
   if (m_state.m_element_tag_state == half_open)
-  {
-    m_os << ">";
-    if (!m_os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	  AIArgs("[DATA]", ">"));
-    }
-  }
+    m_sink.put('>');
   else if (m_state.m_element_tag_state == closed)
   {
-    m_os << std::string(m_state.m_indentation, ' ') << "<" << m_state.m_element_name << ">";
-    if (!m_os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	  AIArgs("[DATA]", "<" + m_state.m_element_name + ">"));
-    }
+    m_sink.append(m_whitespace.data(), m_state.m_indent);
+    if (m_record_index)
+      index_record();
+    m_sink.put('<');
+    m_sink.append(m_state.m_element_name);
+    m_sink.put('>');
   }
-  m_os << escape(element) << "</" << m_state.m_element_name << ">\n";
+  escape_text(m_sink, element);
+  m_sink.append("</", 2);
+  m_sink.append(m_state.m_element_name);
+  m_sink.append(">\n", 1 + m_state.m_eol);
   m_state.m_element_tag_state = closed;
 }
 
-void WriteBridge::write_attribute(char const* name, std::string const& attribute_str)
+void WriteBridge::write_attribute(char const* name, std::string_view attribute_str)
 {
-  std::string escaped_str = escape(attribute_str);
-  m_os << ' ' << name << "=\"" << escaped_str << '"';
-  if (!m_os.good())
-  {
-    THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	AIArgs("[DATA]", std::string(" ") + name + "=\"" + escaped_str + '"'));
-  }
+  m_sink.put(' ');
+  m_sink.append(name, std::strlen(name));
+  m_sink.append("=\"", 2);
+  escape_attribute(m_sink, attribute_str);
+  m_sink.put('"');
+  if (m_record_key_pending)
+    index_key(name, attribute_str);
+}
+
+void WriteBridge::index_record()
+{
+  m_record_key_pending = false;
+  // The parent of the current element is the element of the state on top of the stack.
+  if (m_state_stack.empty() || m_state_stack.top().m_element_name != m_record_index->parent_name())
+    return;
+  m_record_index->add(m_sink.bytes_written());
+  m_record_key_pending = !m_record_index->key_attribute().empty();
+}
+
+void WriteBridge::index_key(char const* name, std::string_view value)
+{
+  if (m_record_index->key_attribute() != name)
+    return;
+  m_record_index->set_key(value);
+  m_record_key_pending = false;
 }
 
-void WriteBridge::state_type::close_child(std::ostream& os)
+uint64_t WriteBridge::profiler_bytes() const
+{
+  return m_sink.bytes_written();
+}
+
+void WriteBridge::state_type::close_child(OutputSink& sink, std::string const& whitespace)
 {
   if (m_element_tag_state == WriteBridge::half_open)
-  {
-    os << " />\n";
-    if (!os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-	  AIArgs("[DATA]", " />\\n"));
-    }
-  }
+    sink.append(" />\n", 3 + m_eol);
   else if (m_element_tag_state == WriteBridge::open)
   {
-    os << std::string(m_indentation, ' ') << "</" << m_element_name << ">\n";
-    if (!os.good())
-    {
-      THROW_FALERT("Failed to write \"[DATA]\" to stream.",
-          AIArgs("[DATA]", std::string(m_indentation, ' ') + "</" + m_element_name + ">\\n"));
-    }
+    sink.append(whitespace.data(), m_end_indent);
+    sink.append("</", 2);
+    sink.append(m_element_name);
+    sink.append(">\n", 1 + m_eol);
   }
   m_element_tag_state = closed;
 }
@@ -175,7 +216,7 @@ void WriteBridge::state_type::close_child(std::ostream& os)
 void WriteBridge::close_child()
 {
   DoutEntering(dc::xmlparser, "WriteBridge::close_child()");
-  m_state.close_child(m_os);
+  m_state.close_child(m_sink, m_whitespace);
   tag_state_type parent_tag_state = m_state.m_parent_tag_state;
   m_state = m_state_stack.top();
   m_state.m_element_tag_state = parent_tag_state;
@@ -183,4 +224,90 @@ void WriteBridge::close_child()
   Bridge::pop_state();
 }
 
+void WriteBridge::write_children_elements(std::size_t count, write_range_type const& write_range)
+{
+  unsigned int const threads = std::min(static_cast<std::size_t>(m_parallel_threads), count);
+  if (threads <= 1 || count < m_parallel_min_elements)
+  {
+    write_range(*this, 0, count);
+    return;
+  }
+
+  DoutEntering(dc::xmlparser, "WriteBridge::write_children_elements(" << count << ", write_range) using " << threads << " threads.");
+
+  // Write what node_name() of the first element would write before its start tag, so
+  // that every thread can start with a closed element inside an open parent.
+  m_state.close_child(m_sink, m_whitespace);
+  if (m_state.m_parent_tag_state == half_open)
+  {
+    m_sink.append(">\n", 1 + m_state.m_eol);
+    m_state.m_parent_tag_state = open;
+  }
+
+  std::vector<std::string> buffers(threads);
+  std::vector<std::exception_ptr> errors(threads);
+  // When indexing, every thread indexes its own buffer; the offsets are adjusted when the buffers are spliced.
+  std::vector<RecordIndex> indexes;
+  if (m_record_index)
+    indexes.resize(threads, RecordIndex(m_record_index->parent_name(), m_record_index->key_attribute()));
+  // The objects that every thread writes are added to the memory accounting of this bridge.
+  std::vector<std::unique_ptr<MemoryAccounting>> accountings(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  try
+  {
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+      std::size_t const first = count * t / threads;
+      std::size_t const last = count * (t + 1) / threads;
+      workers.emplace_back([this, &write_range, &buffer = buffers[t], &error = errors[t], &accounting = accountings[t],
+          index = m_record_index ? &indexes[t] : nullptr, first, last](){
+        Debug(debug::init_thread());
+        try
+        {
+          StringSink sink(buffer);
+          WriteBridge worker(sink, *this);
+          worker.set_record_index(index);
+          if (m_memory_accounting)
+            worker.enable_memory_accounting();
+          {
+            MemoryAccounting::Phase phase(worker.m_memory_accounting.get(), MemoryAccounting::write);
+            write_range(worker, first, last);
+          }
+          worker.m_state.close_child(sink, worker.m_whitespace);
+          sink.flush();
+          accounting = std::move(worker.m_memory_accounting);
+        }
+        catch (...)
+        {
+          error = std::current_exception();
+        }
+      });
+    }
+  }
+  catch (...)
+  {
+    // Failed to start a thread; the threads that were started must be joined before they are destructed.
+    for (std::thread& worker : workers)
+      worker.join();
+    throw;
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  for (std::exception_ptr const& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+  if (m_memory_accounting)
+    for (auto const& accounting : accountings)
+      m_memory_accounting->add_objects(*accounting, MemoryAccounting::write);
+
+  // Splice the output of the threads in order.
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    if (m_record_index)
+      m_record_index->append(indexes[t], m_sink.bytes_written());
+    m_sink.append(buffers[t]);
+  }
+}
+
 } // namespace xml
@@ -21,7 +21,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
  * \class xml::WriteBridge
- * \brief Writes an XML element to a `std::ostream`.
+ * \brief Writes an XML element to an OutputSink.
  *
  * See class Bridge for a detailed description and example code.
  */
@@ -29,9 +29,12 @@
 #pragma once
 
 #include "Bridge.h"
+#include "OutputSink.h"
+#include "Format.h"
 
 #include <cinttypes>
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <stack>
 
@@ -42,32 +45,83 @@ class WriteBridge;
 namespace xml {
 
 class Writer;
+class RecordIndex;
 
 class WriteBridge : public Bridge
 {
+  protected:
+    OutputSink& m_sink;
+    RecordIndex* m_record_index;	// If non-null, the offsets of the records are added to this index.
+
   private:
-    std::ostream& m_os;
+    std::unique_ptr<OutputSink::Streambuf> m_streambuf;	// Only created when get_os() is called.
+    std::unique_ptr<std::ostream> m_os;
     enum tag_state_type { closed, half_open, open };
     struct state_type {
-      int m_indentation;
+      int m_level;			// The depth of the current element (the root element has level 0).
+      int m_indent;			// The number of characters of m_whitespace written before the start tag.
+      int m_end_indent;			// The number of characters of m_whitespace written before the end tag of an element with children.
+      int m_eol;			// The number of newlines (0 or 1) written after the element and after the start tag of its parent.
       tag_state_type m_parent_tag_state;
       std::string m_element_name;
       tag_state_type m_element_tag_state;
 
-      state_type(tag_state_type parent_tag_state) : m_indentation(-2), m_parent_tag_state(parent_tag_state), m_element_tag_state(closed) { }
-      void close_child(std::ostream& os);
+      state_type(tag_state_type parent_tag_state) : m_level(-1), m_indent(0), m_end_indent(0), m_eol(0), m_parent_tag_state(parent_tag_state), m_element_tag_state(closed) { }
+      void close_child(OutputSink& sink, std::string const& whitespace);
     };
     state_type m_state;
     std::stack<state_type> m_state_stack;
+    Format m_format;
+    std::string m_whitespace;		// At least m_indentation * m_level indentation characters.
+    unsigned int m_parallel_threads;	// The number of threads used to write large children() containers.
+    std::size_t m_parallel_min_elements;	// The minimum number of elements a children() container must have to be written in parallel.
+    bool m_record_key_pending;		// Set when the key attribute of the last indexed record was not written yet.
+
+    // Construct a WriteBridge that continues writing the current children() container of \a parent to \a sink.
+    WriteBridge(OutputSink& sink, WriteBridge const& parent);
 
   public:
     /**
       * \brief Construct a WriteBridge.
       *
-      * \param os : the `std::ostream` to write to.
+      * \param sink : the OutputSink to write to.
       * \param version_major : use this as version (returned by Bridge::version()) for this element and its children.
+      * \param format : the indentation and line breaks to use.
+      *
+      * Write errors are only detected when \a sink is flushed.
+      */
+    WriteBridge(OutputSink& sink, uint32_t version_major, Format const& format = Format());
+    ~WriteBridge();
+
+    /**
+      * \brief Write large children() containers using multiple threads.
+      *
+      * \param threads : the number of threads to use; 1 turns parallel writing off (the default).
+      * \param min_elements : containers with less elements than this are always written by the calling thread.
+      *
+      * Each thread writes a consecutive range of elements to a private buffer
+      * and the buffers are appended to the output in order, so the output
+      * is identical to writing sequentially; provided that the xml() member
+      * functions of the elements do not depend on each other: changes made
+      * with set_user_ptr() or set_version() by an element are not seen by
+      * the elements that were handed to other threads, and the elements
+      * may not modify data that is shared between them.
+      *
+      * The elements that are written by other threads are not seen by the
+      * Profiler (see set_profiler): their time is accounted to the element
+      * that contains the container. They are counted by the memory accounting.
+      */
+    void set_parallel(unsigned int threads, std::size_t min_elements = 1024) { m_parallel_threads = threads; m_parallel_min_elements = min_elements; }
+
+    /**
+      * \brief Add the offsets of the records of \a index to it while writing.
+      *
+      * Every element that is written as child of an element with name index->parent_name()
+      * is added to \a index, with the value of its key attribute (if any), and the Writer
+      * sets the document size when done. Offsets are counted from the start of the OutputSink.
+      * Pass nullptr to stop indexing. See RecordIndex.
       */
-    WriteBridge(std::ostream& os, uint32_t version_major);
+    void set_record_index(RecordIndex* index) { m_record_index = index; m_record_key_pending = false; }
 
     /*virtual*/ bool writing() const { return true; }
     /*virtual*/ void node_name(char const* name);
@@ -80,9 +134,17 @@ class WriteBridge : public Bridge
     /*virtual*/ void open_child(char const* name);
     /*virtual*/ void close_child();
     /*virtual*/ std::ostream& get_os();
-    /*virtual*/ void write_attribute(char const* name, std::string const& raw_attribute);
+    /*virtual*/ void write_attribute(char const* name, std::string_view raw_attribute);
     /*virtual*/ void write_child_stream(std::string const& element);
+    /*virtual*/ void write_children_elements(std::size_t count, write_range_type const& write_range);
+    /*virtual*/ uint64_t profiler_bytes() const;
 /// @endcond
+
+  private:
+    // Add the element whose start tag is about to be written to m_record_index, if it is a record.
+    void index_record();
+    // Set the key of the last record if name is the key attribute.
+    void index_key(char const* name, std::string_view value);
 };
 
 } // namespace xml
@@ -23,22 +23,49 @@
 
 #include "sys.h"
 #include "Writer.h"
-#include "utils/AIAlert.h"
+#include "RecordIndex.h"
+#include "OstreamSink.h"
+#include "FileSink.h"
 #include <iostream>
 
 namespace xml {
 
-Header::Header(std::ostream& os) : m_os(os)
+OwnedSink::OwnedSink(std::unique_ptr<FileSink> sink) : m_file_sink(sink.get())
 {
-  os << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n";
-  if (os.bad())
-  {
-    THROW_MALERT("Failed to write xml header.");
-  }
+  m_owned_sink = std::move(sink);
+}
+
+Header::Header(OutputSink& sink, Format const& format)
+{
+  static constexpr std::string_view header = "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n";
+  // No newline after the header in compact mode.
+  sink.append(header.substr(0, header.size() - (format.m_pretty_depth > 0 ? 0 : 1)));
 }
 
 Header::~Header()
 {
 }
 
+Writer::Writer(std::ostream& os, Format const& format) :
+  OwnedSink(std::make_unique<OstreamSink>(os)), Header(*m_owned_sink, format), WriteBridge(*m_owned_sink, 1, format)
+{
+  m_root_depth = 1;
+}
+
+Writer::Writer(boost::filesystem::path const& path, Format const& format) :
+  OwnedSink(std::make_unique<FileSink>(path)), Header(*m_owned_sink, format), WriteBridge(*m_owned_sink, 1, format)
+{
+  m_root_depth = 1;
+}
+
+void Writer::end_document()
+{
+  if (m_record_index)
+    m_record_index->set_document_size(m_sink.bytes_written());
+  if (m_file_sink)
+    m_file_sink->commit();
+  else
+    m_sink.flush();
+}
+
 } // namespace xml
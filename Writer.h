@@ -21,7 +21,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
  * \class xml::Writer
- * \brief Writes an XML structure to a `std::ostream`.
+ * \brief Writes an XML structure to an OutputSink, a `std::ostream` or a file.
  *
  * See class Bridge for a detailed description and example code.
  */
@@ -29,11 +29,36 @@
 #pragma once
 
 #include "WriteBridge.h"
+#include "OutputSink.h"
+#include "Format.h"
 
 #include <iosfwd>
+#include <memory>
+#include <boost/filesystem.hpp>
 
 namespace xml {
 
+class FileSink;
+
+/**
+  * \brief Helper class
+  *
+  * This class owns the OutputSink of a Writer that was constructed
+  * from a `std::ostream` or a path, so that it exists before Header
+  * and WriteBridge are constructed.
+  */
+class OwnedSink
+{
+/// @cond Doxygen_Suppress
+  protected:
+    std::unique_ptr<OutputSink> m_owned_sink;
+    FileSink* m_file_sink = nullptr;		// Set when m_owned_sink is a FileSink.
+    OwnedSink() = default;
+    OwnedSink(std::unique_ptr<OutputSink> sink) : m_owned_sink(std::move(sink)) { }
+    OwnedSink(std::unique_ptr<FileSink> sink);
+/// @endcond
+};
+
 /**
   * \brief Helper class
   *
@@ -45,21 +70,40 @@ class Header
 {
 /// @cond Doxygen_Suppress
   protected:
-    std::ostream& m_os;
-    Header(std::ostream& os);
+    Header(OutputSink& sink, Format const& format);
     virtual ~Header();
 /// @endcond
 };
 
-class Writer : public Header, public WriteBridge
+class Writer : private OwnedSink, public Header, public WriteBridge
 {
   public:
 
-    /// Construct a Writer that can be used to write to an `std::ostream`.
-    Writer(std::ostream& os) : Header(os), WriteBridge(os, 1) { }
+    /**
+      * \brief Construct a Writer that can be used to write to an `std::ostream`, using \a format.
+      *
+      * The output is buffered and written to \a os a buffer at a time. Write errors of \a os
+      * are therefore not reported per tag, but only thrown when the buffer is flushed at the
+      * end of write().
+      */
+    Writer(std::ostream& os, Format const& format = Format());
+
+    /**
+      * \brief Construct a Writer that atomically replaces the file \a path, using \a format.
+      *
+      * The file is written through a FileSink and only replaces \a path
+      * once write() completed successfully. Only one object can be written.
+      */
+    Writer(boost::filesystem::path const& path, Format const& format = Format());
+
+    /// Construct a Writer that can be used to write to \a sink, using \a format.
+    Writer(OutputSink& sink, Format const& format = Format()) : Header(sink, format), WriteBridge(sink, 1, format) { m_root_depth = 1; }
 
     /**
-      * \brief Write \a object as XML to the underlaying ostream.
+      * \brief Write \a object as XML to the underlaying sink.
+      *
+      * The sink is flushed afterwards; write errors are thrown from here.
+      * If the Writer was constructed from a path, the file is committed.
       *
       * \param object : An object of a class type that implements void xml(xml::Bridge&).
       * Because the member function xml(xml::Bridge&) is not const (it is also used
@@ -67,14 +111,21 @@ class Writer : public Header, public WriteBridge
       */
     template<typename T>
       void write(T& object);
+
+  private:
+    void end_document();
 };
 
 template<typename T>
 void Writer::write(T& object)
 {
+  Tracer::Scope trace("Writer::write");
+  MemoryAccounting::Phase phase(m_memory_accounting.get(), MemoryAccounting::write);
+  Profiler::Scope profile(m_profiler, false);
   open_child();
   object.xml(*this);
   close_child();
+  end_document();
 }
 
 } // namespace xml
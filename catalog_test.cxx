@@ -23,14 +23,29 @@
 
 #include "sys.h"
 #include "Reader.h"
+#include "FlatReader.h"
+#include "RecordReader.h"
+#include "ReadCursor.h"
 #include "Writer.h"
+#include "StringSink.h"
+#include "AsyncFdSink.h"
+#include "Tracer.h"
+#include "escape.h"
 #include "debug.h"
 #include "utils/debug_ostream_operators.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <map>
+#include <thread>
+#include <optional>
 #include <vector>
 #include <list>
 #include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <unistd.h>
 
 //#define PRINT_DEBUG
 
@@ -150,6 +165,635 @@ void ColorSwatch::xml(xml::Bridge& xml)
   }
 }
 
+// Return object serialized with a Writer.
+template<typename T>
+std::string write_to_string(T& object, xml::Format const& format = xml::Format())
+{
+  std::ostringstream os;
+  xml::Writer writer(os, format);
+  writer.write(object);
+  return os.str();
+}
+
+// Read a document with a Reader and with a FlatReader; both must read the same values.
+class Indented
+{
+  private:
+    std::string m_text;
+    std::string m_leaf;
+  public:
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("indented");
+      xml.child_stream("parent", m_text);	// The first text node of <parent> is the indentation of <leaf>.
+      xml.child_stream("leaf", m_leaf);
+    }
+};
+
+template<typename T, typename READER>
+void read_stream(std::istream& input, T& object)
+{
+  READER reader;
+  reader.parse(input, 1);
+  reader.read(object);
+}
+
+static bool flat_reader_reads_the_same(fs::path const& filepath)
+{
+  Catalog catalog1, catalog2;
+  {
+    std::ifstream file(filepath.c_str(), std::ios_base::binary);
+    read_stream<Catalog, xml::Reader>(file, catalog1);
+  }
+  {
+    std::ifstream file(filepath.c_str(), std::ios_base::binary);
+    read_stream<Catalog, xml::FlatReader>(file, catalog2);
+  }
+  Indented indented1, indented2;
+  char const* const indented = "<indented>\n  <parent>\n    <leaf/>\n  </parent>\n  <leaf>Foo<!-- comment -->Bar</leaf>\n</indented>";
+  {
+    std::istringstream input(indented);
+    read_stream<Indented, xml::Reader>(input, indented1);
+  }
+  {
+    std::istringstream input(indented);
+    read_stream<Indented, xml::FlatReader>(input, indented2);
+  }
+  if (write_to_string(catalog1) != write_to_string(catalog2) || write_to_string(indented1) != write_to_string(indented2))
+  {
+    std::cerr << "FlatReader read different values than Reader." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A list of siblings with different names; each Shape requests the next name, until one is absent.
+class Shape
+{
+  private:
+    std::string m_id;
+  public:
+    static int s_next;
+    std::string const& id() const { return m_id; }
+    void xml(xml::Bridge& xml)
+    {
+      static char const* const names[] = { "square", "circle", "triangle" };
+      xml.node_name(names[s_next++]);
+      xml.attribute("id", m_id);
+    }
+};
+
+int Shape::s_next;
+
+class Drawing
+{
+  private:
+    std::vector<Shape> m_shapes;
+  public:
+    std::vector<Shape> const& shapes() const { return m_shapes; }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("drawing");
+      xml.children("shapes", m_shapes);
+    }
+};
+
+// Return the ids of the shapes in drawing, space separated.
+static std::string shape_ids(Drawing const& drawing)
+{
+  std::string ids;
+  for (Shape const& shape : drawing.shapes())
+    ids += (ids.empty() ? "" : " ") + shape.id();
+  return ids;
+}
+
+// Read with a learned Projection; this must read the same values as without one.
+static bool projection_reads_the_same()
+{
+  // The nested <circle> must not be read: the circle that is requested after the square is its sibling.
+  char const* const document = "<drawing><shapes><square id=\"1\"><circle id=\"9\"/></square><circle id=\"2\"/></shapes></drawing>";
+  xml::Projection projection;
+  Drawing learned, projected, flat;
+  {
+    xml::Reader reader;
+    reader.learn_projection(&projection);
+    std::istringstream input(document);
+    reader.parse(input, 1);
+    Shape::s_next = 0;
+    reader.read(learned);
+  }
+  {
+    xml::Reader reader;
+    std::istringstream input(document);
+    reader.parse(input, 1, projection);
+    Shape::s_next = 0;
+    reader.read(projected);
+  }
+  {
+    std::istringstream input(document);
+    Shape::s_next = 0;
+    read_stream<Drawing, xml::FlatReader>(input, flat);
+  }
+  if (shape_ids(learned) != "1 2" || shape_ids(projected) != "1 2" || shape_ids(flat) != "1 2")
+  {
+    std::cerr << "Read shapes \"" << shape_ids(learned) << "\", with the learned projection \"" << shape_ids(projected) <<
+        "\" and with FlatReader \"" << shape_ids(flat) << "\", expected \"1 2\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// An <entry> with a name; when read, the user pointer must be the one of the root element.
+class Entry
+{
+  private:
+    std::string m_name;
+  public:
+    Entry() = default;
+    Entry(std::string const& name) : m_name(name) { }
+    std::string const& name() const { return m_name; }
+    void xml(xml::Bridge& xml)
+    {
+      if (!xml.writing() && xml.get_user_ptr())
+        THROW_ALERT("The user pointer of a previous read is still set");
+      xml.node_name("entry");
+      xml.attribute("name", m_name);
+    }
+};
+
+// An <entry> with a <detail> child that has no 'missing' attribute; reading it throws below the entry.
+class BrokenEntry
+{
+  private:
+    struct Detail
+    {
+      std::string m_missing;
+      void xml(xml::Bridge& xml)
+      {
+        xml.node_name("detail");
+        xml.set_user_ptr(this);
+        xml.attribute("missing", m_missing);
+      }
+    };
+    Detail m_detail;
+  public:
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("entry");
+      xml.child(m_detail);
+    }
+};
+
+// Read at element paths, also after a read that threw.
+static bool read_at_recovers()
+{
+  xml::Reader reader;
+  std::istringstream input("<entries><entry name=\"a]b\"><detail/></entry><entry name=\"c\"/></entries>");
+  reader.parse(input, 1);
+  BrokenEntry broken;
+  try
+  {
+    reader.read_at("/entries/entry[1]", broken);
+    std::cerr << "Reading <detail> without attribute 'missing' did not throw." << std::endl;
+    return false;
+  }
+  catch (AIAlert::Error const&)
+  {
+  }
+  Entry first, last;
+  if (!reader.read_at("/entries/entry[@name='a]b']", first) || first.name() != "a]b" ||
+      !reader.read_at("/entries/entry[@name=\"c\"][1]", last) || last.name() != "c")
+  {
+    std::cerr << "read_at did not find the entries \"a]b\" and \"c\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Read a stream of records that ends with a comment.
+static bool records_end_before_trailing_comment()
+{
+  std::istringstream input("<entry name=\"a\"/>\n<?pi?><entry name=\"b\"/>\n<!-- end -->\n");
+  xml::RecordReader records(input, 1);
+  std::string names;
+  for (Entry entry; records.read(entry);)
+    names += entry.name();
+  if (names != "ab")
+  {
+    std::cerr << "Read records \"" << names << "\", expected \"ab\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Return str escaped one character at a time, as reference for the escape functions.
+static std::string escape_reference(std::string const& str, char const* specials)
+{
+  std::string result;
+  for (char c : str)
+  {
+    if (!std::strchr(specials, c))
+      result += c;
+    else if (c == '<')
+      result += "&lt;";
+    else if (c == '>')
+      result += "&gt;";
+    else if (c == '&')
+      result += "&amp;";
+    else if (c == '"')
+      result += "&quot;";
+    else
+      result += "&apos;";
+  }
+  return result;
+}
+
+// Escape strings with special and control characters around the 16 and 32 byte boundaries of the vectorized scan.
+static bool escape_is_exact()
+{
+  for (std::size_t offset : { 0, 15, 16, 31, 32, 47 })
+    for (char const* inserted : { "<", "&", "\"", "'", "]]>", "\t", "\x01", "\x1f", "\x7f", "\xc3\xa9" })
+    {
+      std::string str(48, 'a');
+      str.replace(offset, 1, inserted);
+      std::string text, attribute;
+      {
+        xml::StringSink sink(text);
+        xml::escape_text(sink, str);
+      }
+      {
+        xml::StringSink sink(attribute);
+        xml::escape_attribute(sink, str);
+      }
+      if (text != escape_reference(str, "<>&") || attribute != escape_reference(str, "<>&\"") ||
+          xml::escape(str) != escape_reference(str, "<>&\"'") || xml::escape(std::string(str)) != xml::escape(str))
+      {
+        std::cerr << "Wrong escaping of \"" << str << "\"." << std::endl;
+        return false;
+      }
+    }
+  // Read back what was written.
+  std::string const name = "a<b&c\"d'e]]>f";
+  Entry entry(name), read;
+  std::string xml;
+  {
+    xml::StringSink sink(xml);
+    xml::Writer writer(sink);
+    writer.write(entry);
+  }
+  std::istringstream input(xml);
+  read_stream<Entry, xml::Reader>(input, read);
+  if (read.name() != name)
+  {
+    std::cerr << "Wrote attribute \"" << name << "\" but read back \"" << read.name() << "\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Write catalog in other formats; reading that back must give the same catalog.
+static bool formats_read_the_same(Catalog& catalog)
+{
+  std::string const expected = write_to_string(catalog);
+  struct { char const* m_name; xml::Format m_format; } const formats[] = {
+    { "compact", xml::Format::compact() }, { "tabs", xml::Format::tabs() }, { "pretty_up_to(2)", xml::Format::pretty_up_to(2) }
+  };
+  for (auto const& format : formats)
+  {
+    std::string const output = write_to_string(catalog, format.m_format);
+    Catalog read;
+    std::istringstream input(output);
+    read_stream<Catalog, xml::Reader>(input, read);
+    bool whitespace_ok = true;
+    std::istringstream lines(output);
+    for (std::string line; std::getline(lines, line);)
+    {
+      std::size_t const indent = line.find_first_not_of(" \t");
+      if (format.m_format.m_pretty_depth == 0)
+        whitespace_ok = whitespace_ok && lines.eof();				// No newline at all.
+      else if (format.m_format.m_indent_char == '\t')
+        whitespace_ok = whitespace_ok && line.find_first_not_of('\t') == indent;	// Only tabs.
+      else
+        whitespace_ok = whitespace_ok && indent <= 2;				// Deeper elements are inline.
+    }
+    if (!whitespace_ok || write_to_string(read) != expected)
+    {
+      std::cerr << "Writing the catalog with Format::" << format.m_name << " gave:\n" << output << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Write catalog through an AsyncFdSink, to a file and to a file descriptor that can't be written to.
+static bool async_fd_sink_reports_errors(Catalog& catalog)
+{
+  std::string const expected = write_to_string(catalog);
+  std::FILE* file = std::tmpfile();
+  std::error_code ec;
+  {
+    xml::AsyncFdSink sink(fileno(file), 3, 4096);
+    xml::Writer writer(sink);
+    writer.write(catalog);
+    ec = sink.finish();
+  }
+  std::string output(expected.size() + 1, '\0');
+  std::rewind(file);
+  output.resize(std::fread(output.data(), 1, output.size(), file));
+  std::fclose(file);
+  if (ec || output != expected)
+  {
+    std::cerr << "AsyncFdSink wrote something else than the Writer: " << ec.message() << std::endl;
+    return false;
+  }
+  int const read_only = open("/dev/null", O_RDONLY);
+  xml::AsyncFdSink sink(read_only, 2, 4096);
+  bool thrown = false;
+  try
+  {
+    xml::Writer writer(sink);
+    writer.write(catalog);
+  }
+  catch (AIAlert::Error const&)
+  {
+    thrown = true;
+  }
+  ec = sink.finish();
+  std::error_code const again = sink.finish();
+  close(read_only);
+  if (!thrown || !sink.failed() || ec != std::errc::bad_file_descriptor || again != ec)
+  {
+    std::cerr << "AsyncFdSink did not report the write error to a read-only file descriptor: " << ec.message() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// A list of entries that is written with children() or with write_children() from a range or a generator.
+class EntryList
+{
+  public:
+    enum source_type { container, range, optional_generator, pointer_generator };
+
+  private:
+    std::vector<Entry> m_entries;
+    source_type m_source;
+
+  public:
+    EntryList(source_type source) : m_entries{ Entry("a"), Entry("b<"), Entry("c") }, m_source(source) { }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("list");
+      std::size_t next = 0;
+      switch (m_source)
+      {
+        case container:
+          xml.children("entries", m_entries);
+          break;
+        case range:
+          xml.write_children("entries", m_entries);
+          break;
+        case optional_generator:
+          xml.write_children("entries", [&]() -> std::optional<Entry> {
+            if (next == m_entries.size())
+              return std::nullopt;
+            return m_entries[next++];
+          });
+          break;
+        case pointer_generator:
+          xml.write_children("entries", [&]() -> Entry* { return next == m_entries.size() ? nullptr : &m_entries[next++]; });
+          break;
+      }
+    }
+};
+
+// write_children must write the same as children().
+static bool write_children_writes_the_same()
+{
+  EntryList list(EntryList::container);
+  std::string const expected = write_to_string(list);
+  for (EntryList::source_type source : { EntryList::range, EntryList::optional_generator, EntryList::pointer_generator })
+  {
+    EntryList written(source);
+    std::string const output = write_to_string(written);
+    if (output != expected)
+    {
+      std::cerr << "write_children wrote:\n" << output << "\nwhile children wrote:\n" << expected << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Read a list of entries and numbers with visitors that take their element in every way.
+class VisitedList
+{
+  private:
+    int m_visitor;
+    std::string m_names;
+    int m_sum = 0;
+
+  public:
+    VisitedList(int visitor) : m_visitor(visitor) { }
+    std::string const& names() const { return m_names; }
+    int sum() const { return m_sum; }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("list");
+      switch (m_visitor)
+      {
+        case 0:
+          xml.children("entries", [this](Entry& entry){ m_names += entry.name(); });
+          xml.children_stream("number", [this](int& number){ m_sum += number; });
+          break;
+        case 1:
+          xml.children("entries", [this](Entry&& entry){ Entry moved(std::move(entry)); m_names += moved.name(); });
+          xml.children_stream("number", [this](int&& number){ m_sum += number; });
+          break;
+        case 2:
+          xml.children("entries", [this](Entry const& entry){ m_names += entry.name(); });
+          xml.children_stream("number", [this](int const& number){ m_sum += number; });
+          break;
+        case 3:
+          xml.children("entries", [this](Entry entry){ m_names += entry.name(); });
+          xml.children_stream("number", [this](int number){ m_sum += number; });
+          break;
+      }
+    }
+};
+
+// Every kind of visitor must see the same elements.
+static bool visitors_see_all_elements()
+{
+  char const* const document =
+    "<list><entries><entry name=\"a\"/><entry name=\"b\"/><entry name=\"c\"/></entries><number>1</number><number>2</number></list>";
+  for (int visitor = 0; visitor < 4; ++visitor)
+  {
+    VisitedList list(visitor);
+    std::istringstream input(document);
+    read_stream<VisitedList, xml::Reader>(input, list);
+    if (list.names() != "abc" || list.sum() != 3)
+    {
+      std::cerr << "Visitor " << visitor << " saw entries \"" << list.names() << "\" and numbers adding up to " << list.sum() << "." << std::endl;
+      return false;
+    }
+  }
+  xml::Reader reader;
+  std::istringstream input(document);
+  reader.parse(input, 1);
+  std::string names;
+  std::size_t const count = reader.read_each_at("/list/entries/entry", [&names](Entry&& entry){ names += entry.name(); }) +
+    reader.read_each_at("/list/entries/entry[2]", [&names](Entry& entry){ names += entry.name(); });
+  if (count != 4 || names != "abcb")
+  {
+    std::cerr << "read_each_at visited " << count << " entries \"" << names << "\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Return true if the begin and end events in the trace JSON json are balanced and properly nested.
+static bool trace_is_balanced(std::string const& json, std::size_t& events)
+{
+  std::vector<std::string> open;
+  std::istringstream lines(json);
+  events = 0;
+  for (std::string line; std::getline(lines, line);)
+  {
+    std::size_t const phase = line.find("\"ph\":\"");
+    if (phase == std::string::npos || line.compare(0, 9, "{\"name\":\"") != 0)
+      continue;
+    std::string const name = line.substr(9, line.find('"', 9) - 9);
+    char const ph = line[phase + 6];
+    if (ph == 'B')
+      open.push_back(name);
+    else if (ph == 'E')
+    {
+      if (open.empty() || open.back() != name)
+        return false;
+      open.pop_back();
+    }
+    else
+      continue;
+    ++events;
+  }
+  return open.empty();
+}
+
+// Trace reading and writing the catalog, also with a ring buffer that is too small.
+static bool trace_is_balanced(Catalog& catalog)
+{
+  for (std::size_t capacity : { 4096, 16 })
+  {
+    xml::Tracer::clear();
+    xml::Tracer::enable(3, capacity);
+    // In a new thread, which records into a ring buffer of the new capacity.
+    std::thread thread([&catalog]{
+      for (int i = 0; i < 3; ++i)
+      {
+        std::istringstream input(write_to_string(catalog));
+        Catalog read;
+        read_stream<Catalog, xml::Reader>(input, read);
+      }
+    });
+    thread.join();
+    xml::Tracer::disable();
+    std::ostringstream json;
+    xml::Tracer::write_json(json);
+    xml::Tracer::clear();
+    std::size_t events;
+    if (!trace_is_balanced(json.str(), events) || events == 0 || events > capacity)
+    {
+      std::cerr << "Unbalanced trace with a ring of " << capacity << " events:\n" << json.str() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Read the catalog with two ReadCursors of one frozen Reader at the same time.
+static bool cursors_read_concurrently(fs::path const& filepath, Catalog& catalog)
+{
+  std::string const expected = write_to_string(catalog);
+  xml::Reader reader;
+  std::ifstream file(filepath.c_str(), std::ios_base::binary);
+  reader.parse(file, 1);
+  reader.freeze();
+  std::string outputs[2];
+  std::thread threads[2];
+  for (int t = 0; t < 2; ++t)
+    threads[t] = std::thread([&reader, &output = outputs[t], &expected]{
+      xml::ReadCursor cursor(reader);
+      for (int i = 0; i < 100 && output.empty(); ++i)
+      {
+        Catalog read;
+        cursor.read(read);
+        if (write_to_string(read) != expected)
+          output = write_to_string(read);
+      }
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+  for (std::string const& output : outputs)
+    if (!output.empty())
+    {
+      std::cerr << "A ReadCursor read:\n" << output << std::endl;
+      return false;
+    }
+  return true;
+}
+
+// Two attributes and the text of a child read as string_view.
+class Views
+{
+  private:
+    std::string_view m_first;
+    std::string_view m_second;
+    std::string_view m_text;
+  public:
+    std::string values() const { return std::string(m_first) + '|' + std::string(m_second) + '|' + std::string(m_text); }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("views");
+      xml.attribute("first", m_first);
+      xml.attribute("second", m_second);
+      xml.child_stream("text", m_text);
+    }
+};
+
+// Read attributes with entities into string_views; each view must keep its own value.
+static bool string_views_of_entities()
+{
+  char const* const document =
+    "<!DOCTYPE views [<!ENTITY e \"ent\">]><views first=\"a&amp;b&e;c\" second=\"&lt;&#65;&e;&gt;\"><text>x&amp;&e;y</text></views>";
+  std::string const expected = "a&bentc|<Aent>|x&enty";
+  std::string values[2];
+  {
+    xml::Reader reader;
+    reader.set_string_views(true);
+    std::istringstream input(document);
+    reader.parse(input, 1);
+    Views views;
+    reader.read(views);
+    values[0] = views.values();
+  }
+  {
+    xml::FlatReader reader;
+    reader.set_string_views(true);
+    std::istringstream input(document);
+    reader.parse(input, 1);
+    Views views;
+    reader.read(views);
+    values[1] = views.values();
+  }
+  if (values[0] != expected || values[1] != expected)
+  {
+    std::cerr << "Read \"" << values[0] << "\" and with FlatReader \"" << values[1] << "\", expected \"" << expected << "\"." << std::endl;
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char* argv[])
 {
   Debug(debug::init());
@@ -161,6 +805,18 @@ int main(int argc, char* argv[])
   }
 
   fs::path filepath(argv[1]);
+
+  try
+  {
+    if (!flat_reader_reads_the_same(filepath) || !projection_reads_the_same() || !read_at_recovers() || !records_end_before_trailing_comment() || !escape_is_exact() || !write_children_writes_the_same() || !visitors_see_all_elements() || !string_views_of_entities())
+      return 1;
+  }
+  catch (AIAlert::Error const& error)
+  {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
   xml::Reader reader;
 
   Catalog catalog;
@@ -181,6 +837,17 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  try
+  {
+    if (!formats_read_the_same(catalog) || !async_fd_sink_reports_errors(catalog) || !trace_is_balanced(catalog) || !cursors_read_concurrently(filepath, catalog))
+      return 1;
+  }
+  catch (AIAlert::Error const& error)
+  {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
 #ifdef PRINT_DEBUG
   DebugBuf buf;
   std::ostream dout(&buf);
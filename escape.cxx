@@ -22,41 +22,170 @@
  */
 
 #include "sys.h"
+#include "escape.h"
+#include "OutputSink.h"
 #include <string>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace xml {
 
-std::string escape(std::string const& str)
+namespace {
+
+// The sets of characters that need escaping.
+enum escape_rule_type {
+  text_rule,		// <>&
+  attribute_rule,	// <>&"
+  legacy_rule		// <>&"'
+};
+
+template<escape_rule_type rule>
+inline bool is_special(char c)
 {
-  std::string result;
-  for (std::string::const_iterator iter = str.begin(); iter != str.end(); ++iter)
+  return c == '<' || c == '>' || c == '&' ||
+    (rule != text_rule && c == '"') ||
+    (rule == legacy_rule && c == '\'');
+}
+
+// Return a pointer to the first character in [p, end) that needs escaping, or end if there is none.
+template<escape_rule_type rule>
+char const* find_special(char const* p, char const* end)
+{
+#ifdef __AVX2__
+  if (end - p >= 32)
+  {
+    __m256i const lt = _mm256_set1_epi8('<');
+    __m256i const gt = _mm256_set1_epi8('>');
+    __m256i const amp = _mm256_set1_epi8('&');
+    __m256i const quot = _mm256_set1_epi8('"');
+    __m256i const apos = _mm256_set1_epi8('\'');
+    do
+    {
+      __m256i const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      __m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, lt), _mm256_cmpeq_epi8(chunk, gt)), _mm256_cmpeq_epi8(chunk, amp));
+      if (rule != text_rule)
+        match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, quot));
+      if (rule == legacy_rule)
+        match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, apos));
+      unsigned int mask = _mm256_movemask_epi8(match);
+      if (mask)
+        return p + __builtin_ctz(mask);
+      p += 32;
+    }
+    while (end - p >= 32);
+  }
+#endif
+#ifdef __SSE2__
+  if (end - p >= 16)
   {
-    char const c = *iter;
-    switch (c)
+    __m128i const lt = _mm_set1_epi8('<');
+    __m128i const gt = _mm_set1_epi8('>');
+    __m128i const amp = _mm_set1_epi8('&');
+    __m128i const quot = _mm_set1_epi8('"');
+    __m128i const apos = _mm_set1_epi8('\'');
+    do
     {
-      case '<':
-	result.append("&lt;");
-	break;
-      case '>':
-	result.append("&gt;");
-	break;
-      case '&':
-	result.append("&amp;");
-	break;
-      case '"':
-        result.append("&quot;");
-	break;
-      case '\'':
-	result.append("&apos;");
-	break;
-      default:
-	result.push_back(c);
-	break;
+      __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+      __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)), _mm_cmpeq_epi8(chunk, amp));
+      if (rule != text_rule)
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, quot));
+      if (rule == legacy_rule)
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, apos));
+      unsigned int mask = _mm_movemask_epi8(match);
+      if (mask)
+        return p + __builtin_ctz(mask);
+      p += 16;
     }
+    while (end - p >= 16);
+  }
+#endif
+  while (p != end && !is_special<rule>(*p))
+    ++p;
+  return p;
+}
+
+std::string_view entity(char c)
+{
+  switch (c)
+  {
+    case '<':
+      return "&lt;";
+    case '>':
+      return "&gt;";
+    case '&':
+      return "&amp;";
+    case '"':
+      return "&quot;";
+  }
+  return "&apos;";
+}
+
+template<escape_rule_type rule>
+void escape_to(OutputSink& sink, std::string_view str)
+{
+  char const* p = str.data();
+  char const* const end = p + str.size();
+  for (;;)
+  {
+    char const* special = find_special<rule>(p, end);
+    sink.append(p, special - p);
+    if (special == end)
+      break;
+    sink.append(entity(*special));
+    p = special + 1;
+  }
+}
+
+// Return str escaped, where special is the first character of str that needs escaping.
+std::string escape_from(std::string_view str, char const* special)
+{
+  char const* p = str.data();
+  char const* const end = p + str.size();
+  std::string result;
+  result.reserve(str.size() + 16);
+  for (;;)
+  {
+    result.append(p, special);
+    if (special == end)
+      break;
+    result.append(entity(*special));
+    p = special + 1;
+    special = find_special<legacy_rule>(p, end);
   }
   return result;
 }
 
+} // namespace
+
+std::string escape(std::string const& str)
+{
+  char const* const end = str.data() + str.size();
+  char const* special = find_special<legacy_rule>(str.data(), end);
+  if (special == end)
+    return str;
+  return escape_from(str, special);
+}
+
+std::string escape(std::string&& str)
+{
+  char const* const end = str.data() + str.size();
+  char const* special = find_special<legacy_rule>(str.data(), end);
+  if (special == end)
+    return std::move(str);
+  return escape_from(str, special);
+}
+
+void escape_attribute(OutputSink& sink, std::string_view str)
+{
+  escape_to<attribute_rule>(sink, str);
+}
+
+void escape_text(OutputSink& sink, std::string_view str)
+{
+  escape_to<text_rule>(sink, str);
+}
+
 // Replace '--' with '- -', see http://en.wikipedia.org/wiki/XML#Comments
 std::string escape_comment(std::string const& comment)
 {
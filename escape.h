@@ -24,9 +24,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace xml {
 
+class OutputSink;
+
 /**
   * \brief Returns \a str using XML escapes.
   *
@@ -38,6 +41,29 @@ namespace xml {
   */
 std::string escape(std::string const& str);
 
+/// Same as above, but \a str is moved into the result when nothing needs escaping.
+std::string escape(std::string&& str);
+
+/**
+  * \brief Append \a str to \a sink, escaped for use as (double quoted) attribute value.
+  *
+  * - '<' --> "&lt;"
+  * - '>' --> "&gt;"
+  * - '&' --> "&amp;"
+  * - '"' --> "&quot;"
+  *
+  * The string is scanned 16 or 32 bytes at a time (when SSE2 or AVX2 is available)
+  * and runs without special characters are appended with a single copy.
+  */
+void escape_attribute(OutputSink& sink, std::string_view str);
+
+/**
+  * \brief Append \a str to \a sink, escaped for use as text content of an element.
+  *
+  * Same as escape_attribute, except that '"' is not escaped.
+  */
+void escape_text(OutputSink& sink, std::string_view str);
+
 /**
   * \brief Returns \a comment, 'escaped' in a way that XML will not interpret it anymore as XML comment.
   */
@@ -25,11 +25,15 @@
 #include "utils/AIAlert.h"
 #include "xml/Reader.h"
 #include "xml/Writer.h"
+#include "xml/write_to_stream.h"
+#include "xml/read_from_stream.h"
 #include "debug.h"
 #include "utils/debug_ostream_operators.h"
 #include <iostream>
 #include <boost/filesystem.hpp>
 #include <set>
+#include <sstream>
+#include <vector>
 
 #undef PRINT_DEBUG
 
@@ -159,6 +163,86 @@ void Example::xml(xml::Bridge& xml)
   }
 }
 
+// Round-trip vectors long enough that write_to_stream flushes its local buffer, including
+// when the flush happens right after the last element.
+static bool vector_round_trip()
+{
+  for (std::size_t n = 1; n <= 1100; ++n)
+  {
+    std::vector<int> const vec(n, 1234567);
+    std::ostringstream oss;
+    xml::write_to_stream(oss, vec);
+    std::string const str = oss.str();
+    std::istringstream iss(str);
+    std::vector<int> vec2;
+    xml::read_from_stream(iss, vec2);
+    if (!oss.good() || str.size() != 8 * n - 1 || vec2 != vec)
+    {
+      std::cerr << "Round-trip of std::vector<int> with " << n << " elements failed." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// A record of the container that is written in parallel.
+class Record
+{
+  private:
+    int m_id;
+    std::string m_name;
+    std::vector<int> m_values;
+
+  public:
+    Record(int id = 0) : m_id(id), m_name("record " + std::to_string(id)), m_values(id % 5, id) { }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("record");
+      xml.attribute("id", m_id);
+      xml.child_stream("name", m_name);
+      if (!m_values.empty())
+        xml.child_stream("values", m_values);
+    }
+};
+
+class Records
+{
+  private:
+    std::vector<Record> m_records;
+
+  public:
+    Records(int count) { for (int id = 0; id < count; ++id) m_records.emplace_back(id); }
+    void xml(xml::Bridge& xml)
+    {
+      xml.node_name("records");
+      xml.children("list", m_records);
+    }
+};
+
+// Write object with parallel writing turned on and off; the output must be identical.
+template<typename T>
+static bool parallel_write_is_identical(T& object, char const* what)
+{
+  std::ostringstream sequential;
+  {
+    xml::Writer writer(sequential);
+    writer.write(object);
+  }
+  for (unsigned int threads = 2; threads <= 4; ++threads)
+  {
+    std::ostringstream parallel;
+    xml::Writer writer(parallel);
+    writer.set_parallel(threads, 1);
+    writer.write(object);
+    if (parallel.str() != sequential.str())
+    {
+      std::cerr << "Writing " << what << " with " << threads << " threads differs from writing it sequentially." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 int main(int argc, char* argv[])
 {
   Debug(debug::init());
@@ -169,6 +253,9 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  if (!vector_round_trip())
+    return 1;
+
   fs::path filepath(argv[1]);
   xml::Reader reader;
 
@@ -190,6 +277,11 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  // Not the example itself: the set_version() of one <foobar> is seen by the next one, which parallel writing doesn't support.
+  Records records(5000);
+  if (!parallel_write_is_identical(records, "5000 records"))
+    return 1;
+
 #ifdef PRINT_DEBUG
   DebugBuf buf;
   std::ostream dout(&buf);
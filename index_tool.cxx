@@ -0,0 +1,122 @@
+/**
+ * @file
+ * @brief Builds, inspects and uses a RecordIndex of an XML document.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * Usage: index_tool [--key ATTRIBUTE] [--output INDEX] DOCUMENT PARENT
+ *        index_tool --print N [--index INDEX] DOCUMENT
+ *
+ * The first form scans DOCUMENT once and writes an index of the child
+ * elements of all elements with name PARENT to INDEX (default DOCUMENT.idx),
+ * including the value of their attribute ATTRIBUTE when --key is given.
+ *
+ * The second form uses the index to print record N (counting from zero)
+ * of DOCUMENT to stdout, without reading anything else. N may also be
+ * given as `key=VALUE` to look up a record by its key.
+ */
+
+#include "sys.h"
+#include "RecordIndex.h"
+#include "utils/AIAlert.h"
+#include "debug.h"
+#include <boost/filesystem/fstream.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+int main(int argc, char* argv[])
+{
+  Debug(debug::init());
+  Debug(libcw_do.off());
+
+  std::string key_attribute;
+  std::string index_path;
+  std::string print;
+  std::vector<std::string> arguments;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool const has_value = i + 1 < argc;
+    if (arg == "--key" && has_value)
+      key_attribute = argv[++i];
+    else if ((arg == "--output" || arg == "--index") && has_value)
+      index_path = argv[++i];
+    else if (arg == "--print" && has_value)
+      print = argv[++i];
+    else if (arg[0] != '-')
+      arguments.push_back(arg);
+    else
+      arguments.clear();
+  }
+  if (arguments.size() != (print.empty() ? 2 : 1))
+  {
+    std::cerr << "Usage: " << argv[0] << " [--key ATTRIBUTE] [--output INDEX] DOCUMENT PARENT\n"
+                 "       " << argv[0] << " --print N|key=VALUE [--index INDEX] DOCUMENT" << std::endl;
+    return 1;
+  }
+  fs::path const document_path(arguments[0]);
+  if (index_path.empty())
+    index_path = document_path.string() + ".idx";
+
+  try
+  {
+    fs::ifstream document(document_path, std::ios_base::binary);
+    if (!document)
+    {
+      THROW_ALERT("Cannot open \"[FILE]\".", AIArgs("[FILE]", document_path.string()));
+    }
+    if (print.empty())
+    {
+      xml::RecordIndex index(arguments[1], key_attribute);
+      index.build(document);
+      index.save(index_path);
+      std::cout << "Indexed " << index.size() << " children of <" << index.parent_name() << "> in " << document_path <<
+        " (" << index.document_size() << " bytes) to " << index_path << "." << std::endl;
+    }
+    else
+    {
+      xml::RecordIndex index;
+      index.load(index_path);
+      std::size_t n;
+      if (print.compare(0, 4, "key=") == 0)
+      {
+        std::optional<std::size_t> found = index.find(print.substr(4));
+        if (!found)
+        {
+          THROW_ALERT("No record with key \"[KEY]\".", AIArgs("[KEY]", print.substr(4)));
+        }
+        n = *found;
+      }
+      else
+        n = std::strtoull(print.c_str(), nullptr, 10);
+      std::cout << index.record(document, n) << std::endl;
+    }
+  }
+  catch (AIAlert::Error const& error)
+  {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+}
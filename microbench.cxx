@@ -0,0 +1,365 @@
+/**
+ * @file
+ * @brief Microbenchmarks of the primitive hot paths of ai-xml.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Usage: microbench [--json] [--min-time SECONDS] [FILTER...]
+ *
+ * Runs every benchmark whose name contains one of the FILTER strings
+ * (all benchmarks when none is given) and prints one line per benchmark
+ * to stdout: CSV with a header line by default, or JSON with --json.
+ * The columns are the name, the number of iterations, the time per
+ * operation in nanoseconds, the number of bytes processed per operation
+ * and the resulting throughput in MB/s (zero when not applicable).
+ */
+
+#include "sys.h"
+#include "Reader.h"
+#include "Writer.h"
+#include "OutputSink.h"
+#include "escape.h"
+#include "read_from_string.h"
+#include "read_from_stream.h"
+#include "write_to_stream.h"
+#include "debug.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Prevent the compiler from optimizing away the computation of value.
+template<typename T>
+void do_not_optimize(T const& value)
+{
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+// An OutputSink that discards everything.
+class NullSink : public xml::BufferedSink
+{
+  public:
+    NullSink() : BufferedSink(default_buffer_size) { }
+    ~NullSink() override { sync(); }
+
+  protected:
+    void write_out(char const* data, std::size_t UNUSED_ARG(len)) override { do_not_optimize(data); }
+};
+
+struct Result
+{
+  std::string m_name;
+  uint64_t m_iterations;
+  double m_ns_per_op;
+  std::size_t m_bytes_per_op;
+};
+
+class Bench
+{
+  private:
+    double m_min_time;
+    std::vector<std::string> m_filters;
+    bool m_json;
+    bool m_first;
+
+  public:
+    Bench(double min_time, std::vector<std::string> filters, bool json) :
+      m_min_time(min_time), m_filters(std::move(filters)), m_json(json), m_first(true) { }
+
+    ~Bench()
+    {
+      if (m_json)
+        std::cout << (m_first ? "[" : "\n") << "]" << std::endl;
+    }
+
+    // Run op() repeatedly for at least m_min_time seconds and report the time per call.
+    // bytes_per_op is the number of input or output bytes that one call processes.
+    template<typename OP>
+    void run(std::string const& name, std::size_t bytes_per_op, OP&& op)
+    {
+      if (!selected(name))
+        return;
+      using clock_type = std::chrono::steady_clock;
+      // Warm up.
+      op();
+      uint64_t iterations = 0;
+      uint64_t batch = 1;
+      std::chrono::duration<double> elapsed(0);
+      while (elapsed.count() < m_min_time)
+      {
+        auto start = clock_type::now();
+        for (uint64_t i = 0; i < batch; ++i)
+          op();
+        elapsed += clock_type::now() - start;
+        iterations += batch;
+        if (batch < (uint64_t{1} << 30))
+          batch *= 2;
+      }
+      report({name, iterations, elapsed.count() * 1e9 / iterations, bytes_per_op});
+    }
+
+  private:
+    bool selected(std::string const& name) const
+    {
+      if (m_filters.empty())
+        return true;
+      for (std::string const& filter : m_filters)
+        if (name.find(filter) != std::string::npos)
+          return true;
+      return false;
+    }
+
+    void report(Result const& result)
+    {
+      double mb_per_s = result.m_bytes_per_op * 1e3 / result.m_ns_per_op;
+      if (m_json)
+      {
+        std::cout << (m_first ? "[\n" : ",\n") << std::fixed << std::setprecision(3) <<
+          "  { \"name\": \"" << result.m_name << "\", \"iterations\": " << result.m_iterations <<
+          ", \"ns_per_op\": " << result.m_ns_per_op << ", \"bytes_per_op\": " << result.m_bytes_per_op <<
+          ", \"mb_per_s\": " << mb_per_s << " }" << std::flush;
+      }
+      else
+      {
+        if (m_first)
+          std::cout << "name,iterations,ns_per_op,bytes_per_op,mb_per_s\n";
+        std::cout << std::fixed << std::setprecision(3) << result.m_name << ',' << result.m_iterations << ',' <<
+          result.m_ns_per_op << ',' << result.m_bytes_per_op << ',' << mb_per_s << std::endl;
+      }
+      m_first = false;
+    }
+};
+
+// Return a string of len bytes of text, with one character that needs escaping every special_every bytes (never when zero).
+std::string make_text(std::size_t len, std::size_t special_every)
+{
+  static char const plain[] = "The quick brown fox jumps over the lazy dog. ";
+  static char const special[] = "<>&\"";
+  std::string text;
+  text.reserve(len);
+  for (std::size_t i = 0; i < len; ++i)
+    text += (special_every && i % special_every == special_every - 1) ? special[i / special_every % 4] : plain[i % (sizeof(plain) - 1)];
+  return text;
+}
+
+template<typename T>
+void bench_read_from_string(Bench& bench, char const* type_name, std::string const& str)
+{
+  bench.run(std::string("read_from_string/") + type_name, str.size(), [&str]{
+    T value;
+    xml::read_from_string(value, str);
+    do_not_optimize(value);
+  });
+}
+
+template<typename T>
+void bench_write_to_stream(Bench& bench, char const* type_name, T const& value)
+{
+  NullSink sink;
+  xml::OutputSink::Streambuf buf(sink);
+  std::ostream os(&buf);
+  os << std::unitbuf;		// Like WriteBridge::get_os, so that bytes_written() is up to date.
+  std::size_t const start = sink.bytes_written();
+  xml::write_to_stream(os, value);
+  std::size_t const bytes = sink.bytes_written() - start;
+  bench.run(std::string("write_to_stream/") + type_name, bytes, [&]{
+    xml::write_to_stream(os, value);
+  });
+}
+
+template<typename T>
+void bench_read_from_stream(Bench& bench, char const* type_name, std::string const& str)
+{
+  bench.run(std::string("read_from_stream/") + type_name, str.size(), [&str]{
+    std::istringstream iss(str);
+    T value;
+    xml::read_from_stream(iss, value);
+    do_not_optimize(value);
+  });
+}
+
+// An element with one attribute and a text child, used by the Reader and Writer benchmarks.
+struct Item
+{
+  int m_id;
+  std::string m_name;
+
+  void xml(xml::Bridge& xml)
+  {
+    xml.node_name("item");
+    xml.attribute("id", m_id);
+    xml.child_stream("name", m_name);
+  }
+};
+
+struct ItemList
+{
+  std::vector<Item> m_items;
+
+  void xml(xml::Bridge& xml)
+  {
+    xml.node_name("list");
+    xml.children("items", m_items);
+  }
+};
+
+// A Reader whose document can be deserialized more than once.
+class RewindableReader : public xml::Reader
+{
+  public:
+    void rewind()
+    {
+      state_type fresh;
+      m_state.swap(fresh);
+    }
+};
+
+void bench_bridges(Bench& bench, std::size_t count)
+{
+  ItemList list;
+  for (std::size_t i = 0; i < count; ++i)
+    list.m_items.push_back({static_cast<int>(i), "item" + std::to_string(i)});
+
+  std::string document;
+  {
+    std::ostringstream oss;
+    xml::Writer writer(oss);
+    writer.write(list);
+    document = oss.str();
+  }
+
+  std::string const suffix = "/" + std::to_string(count);
+  bench.run("WriteBridge/elements" + suffix, document.size(), [&list]{
+    NullSink sink;
+    xml::Writer writer(sink);
+    writer.write(list);
+  });
+
+  std::istringstream iss(document);
+  RewindableReader reader;
+  reader.parse(iss, 1);
+  bench.run("ReadBridge/node_name" + suffix, document.size(), [&reader]{
+    ItemList result;
+    reader.rewind();
+    result.xml(reader);
+    do_not_optimize(result);
+  });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(debug::init());
+  Debug(libcw_do.off());
+
+  bool json = false;
+  double min_time = 0.2;
+  std::vector<std::string> filters;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+      min_time = std::atof(argv[++i]);
+    else if (argv[i][0] == '-')
+    {
+      std::cerr << "Usage: " << argv[0] << " [--json] [--min-time SECONDS] [FILTER...]" << std::endl;
+      return 1;
+    }
+    else
+      filters.push_back(argv[i]);
+  }
+
+  Bench bench(min_time, std::move(filters), json);
+
+  // Escaping.
+  for (std::size_t special_every : {0, 64, 8})
+  {
+    std::string const text = make_text(4096, special_every);
+    std::string const suffix = "/4096/" + (special_every ? "1in" + std::to_string(special_every) : std::string("plain"));
+    bench.run("escape" + suffix, text.size(), [&text]{
+      std::string result = xml::escape(text);
+      do_not_optimize(result);
+    });
+    NullSink sink;
+    bench.run("escape_attribute" + suffix, text.size(), [&]{ xml::escape_attribute(sink, text); });
+    bench.run("escape_text" + suffix, text.size(), [&]{ xml::escape_text(sink, text); });
+  }
+  {
+    std::string const comment = make_text(1024, 0) + "--" + make_text(1024, 0) + "--";
+    bench.run("escape_comment/2052", comment.size(), [&comment]{
+      std::string result = xml::escape_comment(comment);
+      do_not_optimize(result);
+    });
+  }
+
+  // read_from_string.
+  bench_read_from_string<uint8_t>(bench, "uint8_t", "200");
+  bench_read_from_string<int8_t>(bench, "int8_t", "-100");
+  bench_read_from_string<uint16_t>(bench, "uint16_t", "60000");
+  bench_read_from_string<int16_t>(bench, "int16_t", "-30000");
+  bench_read_from_string<uint32_t>(bench, "uint32_t", "4000000000");
+  bench_read_from_string<int32_t>(bench, "int32_t", "-2000000000");
+  bench_read_from_string<float>(bench, "float", "3.1415927");
+  bench_read_from_string<double>(bench, "double", "2.718281828459045");
+  bench_read_from_string<bool>(bench, "bool", "true");
+  bench_read_from_string<std::string>(bench, "std::string", "The quick brown fox");
+
+  // write_to_stream.
+  bench_write_to_stream(bench, "int", 123456789);
+  bench_write_to_stream(bench, "float", 3.1415927f);
+  bench_write_to_stream(bench, "double", 2.718281828459045);
+  bench_write_to_stream(bench, "std::string", std::string("The quick brown fox"));
+  {
+    std::vector<int> ints(1000);
+    std::vector<double> doubles(1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+      ints[i] = i * 7919;
+      doubles[i] = i / 7.0;
+    }
+    bench_write_to_stream(bench, "std::vector<int>/1000", ints);
+    bench_write_to_stream(bench, "std::vector<double>/1000", doubles);
+  }
+
+  // read_from_stream.
+  bench_read_from_stream<std::string>(bench, "std::string/4096", make_text(4096, 0));
+  {
+    std::ostringstream ints;
+    std::ostringstream strings;
+    for (int i = 0; i < 1000; ++i)
+    {
+      ints << (i ? " " : "") << i * 7919;
+      strings << (i ? " " : "") << "word" << i;
+    }
+    bench_read_from_stream<std::vector<int>>(bench, "std::vector<int>/1000", ints.str());
+    bench_read_from_stream<std::vector<std::string>>(bench, "std::vector<std::string>/1000", strings.str());
+  }
+
+  // Bridge layer.
+  bench_bridges(bench, 10);
+  bench_bridges(bench, 10000);
+}
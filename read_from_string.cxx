@@ -23,80 +23,115 @@
 
 #include "read_from_string.h"
 #include "utils/AIAlert.h"
+#include <charconv>
+#include <cctype>
+#include <cstdlib>
 #include <limits>
-#include <cstdio>
+#include <string>
+#include <type_traits>
 
 namespace xml {
 
+namespace {
+
+// Skip the whitespace and '+' that may precede a value.
+char const* skip_sign(char const* first, char const* last)
+{
+  while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+    ++first;
+  if (first != last && *first == '+')
+    ++first;
+  return first;
+}
+
+} // namespace
+
 template<typename T>
-T read_integer(char const* type, std::string const& str)
+T read_integer(char const* type, std::string_view str)
 {
+  char const* const last = str.data() + str.size();
   long long int result;
-  sscanf(str.c_str(),"%lld", &result);
-  if (result < (std::numeric_limits<T>::min)() || result > (std::numeric_limits<T>::max)())
+  std::from_chars_result res = std::from_chars(skip_sign(str.data(), last), last, result);
+  if (res.ec != std::errc() || result < (std::numeric_limits<T>::min)() || result > (std::numeric_limits<T>::max)())
+  {
+    THROW_MALERT("Invalid [TYPE] [VALUE]", AIArgs("[TYPE]", type)("[VALUE]", std::string(str)));
+  }
+  return result;
+}
+
+// Use std::from_chars, which is exact, so that values written with write_to_chars read back to the same value.
+template<typename T>
+T read_float(char const* type, std::string_view str)
+{
+  char const* const last = str.data() + str.size();
+  T result;
+  std::from_chars_result res = std::from_chars(skip_sign(str.data(), last), last, result);
+  if (res.ec == std::errc::result_out_of_range)
+  {
+    // Like sscanf, that was used before: too large values read as infinity, too small ones as (signed) zero.
+    std::string const value(str);
+    if constexpr (std::is_same_v<T, float>)
+      result = std::strtof(value.c_str(), nullptr);
+    else
+      result = std::strtod(value.c_str(), nullptr);
+  }
+  else if (res.ec != std::errc())
   {
-    THROW_MALERT("Invalid [TYPE] [VALUE]", AIArgs("[TYPE]", type)("[VALUE]", str));
+    THROW_MALERT("Invalid [TYPE] [VALUE]", AIArgs("[TYPE]", type)("[VALUE]", std::string(str)));
   }
   return result;
 }
 
 template<>
-void read_from_string(uint8_t& out, std::string const& str)
+void read_from_chars(uint8_t& out, std::string_view str)
 {
   out = read_integer<uint8_t>("uint8_t", str);
 }
 
 template<>
-void read_from_string(int8_t& out, std::string const& str)
+void read_from_chars(int8_t& out, std::string_view str)
 {
   out = read_integer<int8_t>("int8_t", str);
 }
 
 template<>
-void read_from_string(uint16_t& out, std::string const& str)
+void read_from_chars(uint16_t& out, std::string_view str)
 {
   out = read_integer<uint16_t>("uint16_t", str);
 }
 
 template<>
-void read_from_string(int16_t& out, std::string const& str)
+void read_from_chars(int16_t& out, std::string_view str)
 {
   out = read_integer<int16_t>("int16_t", str);
 }
 
 template<>
-void read_from_string(uint32_t& out, std::string const& str)
+void read_from_chars(uint32_t& out, std::string_view str)
 {
   out = read_integer<uint32_t>("uint32_t", str);
 }
 
 template<>
-void read_from_string(int32_t& out, std::string const& str)
+void read_from_chars(int32_t& out, std::string_view str)
 {
   out = read_integer<int32_t>("int32_t", str);
 }
 
-double read_float(std::string const& str)
-{
-  double result;
-  sscanf(str.c_str(),"%lf", &result);
-  return result;
-}
-
 template<>
-void read_from_string(float& out, std::string const& str)
+void read_from_chars(float& out, std::string_view str)
 {
-  out = read_float(str);
+  out = read_float<float>("float", str);
 }
 
 template<>
-void read_from_string(double& out, std::string const& str)
+void read_from_chars(double& out, std::string_view str)
 {
-  out = read_float(str);
+  out = read_float<double>("double", str);
 }
 
 template<>
-void read_from_string(bool& out, std::string const& str)
+void read_from_chars(bool& out, std::string_view str)
 {
   if (str == "true" || str == "1")
   {
@@ -105,9 +140,63 @@ void read_from_string(bool& out, std::string const& str)
   }
   else if (str != "false" && str != "0")
   {
-    THROW_FMALERT("Invalid boolean [VALUE]", AIArgs("[VALUE]", str));
+    THROW_FMALERT("Invalid boolean [VALUE]", AIArgs("[VALUE]", std::string(str)));
   }
   out = false;
 }
 
+template<>
+void read_from_string(uint8_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(int8_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(uint16_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(int16_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(uint32_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(int32_t& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(float& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(double& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
+template<>
+void read_from_string(bool& out, std::string const& str)
+{
+  read_from_chars(out, str);
+}
+
 } // namespace xml
@@ -24,8 +24,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <new>
 #include <cstdint>
+#include <type_traits>
 
 namespace xml {
 
@@ -87,6 +89,56 @@ template<>
 void read_from_string(bool& out, std::string const& str);
 
 /// @}
+
+/**
+  * \brief Function template to convert the arithmetic value in \a str, with std::from_chars.
+  *
+  * Leading whitespace and a '+' are skipped, and anything after the value is ignored.
+  * Only the types for which has_read_from_chars is true are supported.
+  *
+  * \throws AIAlert::Error when \a str doesn't start with a value of type T.
+  */
+template<typename T>
+void read_from_chars(T& out, std::string_view str);
+
+/// True for the types that read_from_chars supports.
+template<typename T>
+constexpr bool has_read_from_chars =
+    std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, int16_t> ||
+    std::is_same_v<T, uint32_t> || std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double> ||
+    std::is_same_v<T, bool>;
+
+/// @cond Doxygen_Suppress
+template<> void read_from_chars(uint8_t& out, std::string_view str);
+template<> void read_from_chars(int8_t& out, std::string_view str);
+template<> void read_from_chars(uint16_t& out, std::string_view str);
+template<> void read_from_chars(int16_t& out, std::string_view str);
+template<> void read_from_chars(uint32_t& out, std::string_view str);
+template<> void read_from_chars(int32_t& out, std::string_view str);
+template<> void read_from_chars(float& out, std::string_view str);
+template<> void read_from_chars(double& out, std::string_view str);
+template<> void read_from_chars(bool& out, std::string_view str);
+/// @endcond
+
+/**
+  * \brief Convert unescaped XML string \a str to \a obj, without copying \a str where possible.
+  *
+  * `std::string` is assigned, `std::string_view` refers to \a str itself and the types of
+  * read_from_chars are converted with it. Everything else is passed to read_from_string.
+  */
+template<typename T>
+void read_from_view(T& obj, std::string_view str)
+{
+  if constexpr (std::is_same_v<T, std::string>)
+    obj.assign(str.data(), str.size());
+  else if constexpr (std::is_same_v<T, std::string_view>)
+    obj = str;
+  else if constexpr (has_read_from_chars<T>)
+    read_from_chars(obj, str);
+  else
+    read_from_string(obj, std::string(str));
+}
+
 /// @}
 
 } // namespace xml
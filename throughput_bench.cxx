@@ -0,0 +1,381 @@
+/**
+ * @file
+ * @brief End-to-end throughput benchmark of ai-xml with a synthetic corpus generator.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Usage: throughput_bench [OPTIONS]
+ *
+ *   --records N      Number of top-level records (default 1000).
+ *   --size BYTES     Choose --records such that the document is about BYTES large (accepts K, M and G suffixes).
+ *   --fanout N       Number of children of every non-leaf element below a record (default 4).
+ *   --depth N        Number of element levels below the root (default 3).
+ *   --attributes N   Number of attributes per element (default 3).
+ *   --text N         Size of the text of each element in bytes (default 32).
+ *   --seed N         Seed of the generator (default 1).
+ *   --threads N      Measure scaling with 1, 2, 4, ... up to N threads (default: number of cores).
+ *   --repeat N       Number of times each measurement is repeated; the fastest run is reported (default 3).
+ *   --output FILE    Only write the generated corpus to FILE and exit.
+ *   --json           Print JSON instead of CSV.
+ *
+ * The generated documents follow the shape of catalog_test.xml: the element
+ * names of the levels are catalog, product, catalog_item, size and color_swatch
+ * (followed by level5, level6, ... for deeper documents). Every element has
+ * the requested number of attributes, a text child `<description>` and a
+ * container element `<children>` with the elements of the next level.
+ * The same seed and options always generate the same document.
+ *
+ * Measured are:
+ *   - serialize:   Writer writing the object tree to a string;
+ *   - parse:       Reader::parse (libxml2 building the DOM);
+ *   - deserialize: reading the object tree from the parsed DOM (Bridge layer and user code);
+ *   - roundtrip:   parse, deserialize and serialize in 1, 2, 4, ... threads, each with its own Reader and Writer.
+ * Throughput is reported as MB of XML per second, followed by the peak resident set size.
+ */
+
+#include "sys.h"
+#include "Reader.h"
+#include "Writer.h"
+#include "StringSink.h"
+#include "debug.h"
+#include <libxml/parser.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+
+struct Options
+{
+  uint64_t m_records = 1000;
+  uint64_t m_size = 0;
+  int m_fanout = 4;
+  int m_depth = 3;
+  int m_attributes = 3;
+  int m_text = 32;
+  uint64_t m_seed = 1;
+  int m_threads = std::max(1U, std::thread::hardware_concurrency());
+  int m_repeat = 3;
+  std::string m_output;
+  bool m_json = false;
+};
+
+// A small, deterministic pseudo random number generator (xorshift64*).
+class Random
+{
+  private:
+    uint64_t m_state;
+
+  public:
+    Random(uint64_t seed) : m_state(seed * 0x9E3779B97F4A7C15ULL + 1) { }
+
+    uint64_t operator()()
+    {
+      m_state ^= m_state >> 12;
+      m_state ^= m_state << 25;
+      m_state ^= m_state >> 27;
+      return m_state * 0x2545F4914F6CDD1DULL;
+    }
+};
+
+// The depth of the element that is currently being read or written, per thread.
+thread_local int t_level;
+// The level of the leaf elements (--depth).
+int g_depth;
+
+class Element
+{
+  private:
+    std::vector<std::string> m_attributes;
+    std::string m_description;
+    std::vector<Element> m_children;
+
+  public:
+    void generate(Options const& options, Random& random, int level);
+    void xml(xml::Bridge& xml);
+};
+
+char const* element_name(int level)
+{
+  static char const* const names[] = { "catalog", "product", "catalog_item", "size", "color_swatch" };
+  static thread_local std::vector<std::string> deeper;
+  if (level < 5)
+    return names[level];
+  while (static_cast<int>(deeper.size()) <= level - 5)
+    deeper.push_back("level" + std::to_string(deeper.size() + 5));
+  return deeper[level - 5].c_str();
+}
+
+char const* attribute_name(int index)
+{
+  static thread_local std::vector<std::string> names;
+  while (static_cast<int>(names.size()) <= index)
+    names.push_back("a" + std::to_string(names.size()));
+  return names[index].c_str();
+}
+
+void Element::generate(Options const& options, Random& random, int level)
+{
+  static char const alphabet[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789 &<>\"";
+  m_attributes.resize(options.m_attributes);
+  for (std::string& attribute : m_attributes)
+    attribute = std::to_string(random() % 1000000);
+  m_description.resize(options.m_text);
+  for (char& c : m_description)
+    c = alphabet[random() % (sizeof(alphabet) - 1)];
+  if (level < options.m_depth)
+  {
+    m_children.resize(level == 0 ? options.m_records : options.m_fanout);
+    for (Element& child : m_children)
+      child.generate(options, random, level + 1);
+  }
+}
+
+void Element::xml(xml::Bridge& xml)
+{
+  // Restore t_level also when NoChildLeft is thrown by node_name.
+  struct LevelGuard { int m_level; LevelGuard() : m_level(t_level++) { } ~LevelGuard() { --t_level; } } guard;
+  xml.node_name(element_name(guard.m_level));
+  for (std::size_t i = 0; i < m_attributes.size(); ++i)
+    xml.attribute(attribute_name(i), m_attributes[i]);
+  if (!xml.writing())
+  {
+    // Read all attributes that are present.
+    std::string value;
+    for (int i = 0;; ++i)
+    {
+      if (xml.optional_attribute(attribute_name(i), value) != xml::reading_attribute_success)
+        break;
+      m_attributes.push_back(value);
+    }
+  }
+  xml.child_stream("description", m_description);
+  if (guard.m_level < g_depth)
+    xml.children("children", m_children);
+}
+
+uint64_t parse_size(char const* str)
+{
+  char* end;
+  uint64_t size = std::strtoull(str, &end, 10);
+  switch (*end)
+  {
+    case 'G': case 'g': size <<= 10; [[fallthrough]];
+    case 'M': case 'm': size <<= 10; [[fallthrough]];
+    case 'K': case 'k': size <<= 10;
+  }
+  return size;
+}
+
+std::string serialize(Element& root)
+{
+  std::string document;
+  {
+    xml::StringSink sink(document);
+    xml::Writer writer(sink);
+    writer.write(root);
+  }
+  return document;
+}
+
+// Return the time in seconds of the fastest of repeat calls to f().
+template<typename F>
+double best_of(int repeat, F&& f)
+{
+  double best = 1e300;
+  for (int i = 0; i < repeat; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+class Report
+{
+  private:
+    bool m_json;
+    bool m_first;
+
+  public:
+    Report(bool json) : m_json(json), m_first(true) { }
+
+    void result(char const* benchmark, int threads, uint64_t bytes, double seconds)
+    {
+      double const mb_per_s = bytes / seconds / 1e6;
+      if (m_json)
+        std::cout << (m_first ? "{ \"results\": [\n" : ",\n") << std::fixed << std::setprecision(6) <<
+          "  { \"benchmark\": \"" << benchmark << "\", \"threads\": " << threads << ", \"bytes\": " << bytes <<
+          ", \"seconds\": " << seconds << ", \"mb_per_s\": " << std::setprecision(3) << mb_per_s << " }";
+      else
+      {
+        if (m_first)
+          std::cout << "benchmark,threads,bytes,seconds,mb_per_s\n";
+        std::cout << benchmark << ',' << threads << ',' << bytes << ',' << std::fixed << std::setprecision(6) <<
+          seconds << ',' << std::setprecision(3) << mb_per_s << std::endl;
+      }
+      m_first = false;
+    }
+
+    void peak_rss()
+    {
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      if (m_json)
+        std::cout << (m_first ? "{ \"results\": [" : "") << "\n  ],\n  \"peak_rss_kb\": " << usage.ru_maxrss << "\n}" << std::endl;
+      else
+        std::cout << "peak_rss_kb," << usage.ru_maxrss << std::endl;
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(debug::init());
+  Debug(libcw_do.off());
+
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool const has_value = i + 1 < argc;
+    if (arg == "--json")
+      options.m_json = true;
+    else if (arg == "--records" && has_value)
+      options.m_records = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--size" && has_value)
+      options.m_size = parse_size(argv[++i]);
+    else if (arg == "--fanout" && has_value)
+      options.m_fanout = std::atoi(argv[++i]);
+    else if (arg == "--depth" && has_value)
+      options.m_depth = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--attributes" && has_value)
+      options.m_attributes = std::atoi(argv[++i]);
+    else if (arg == "--text" && has_value)
+      options.m_text = std::atoi(argv[++i]);
+    else if (arg == "--seed" && has_value)
+      options.m_seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--threads" && has_value)
+      options.m_threads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--repeat" && has_value)
+      options.m_repeat = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--output" && has_value)
+      options.m_output = argv[++i];
+    else
+    {
+      std::cerr << "Usage: " << argv[0] << " [--records N | --size BYTES] [--fanout N] [--depth N] [--attributes N] [--text N] "
+        "[--seed N] [--threads N] [--repeat N] [--output FILE] [--json]" << std::endl;
+      return 1;
+    }
+  }
+
+  g_depth = options.m_depth;
+
+  // libxml2 must be initialized before it is used from more than one thread.
+  xmlInitParser();
+
+  if (options.m_size > 0)
+  {
+    // Measure the size of a single record and scale the number of records accordingly.
+    Options probe = options;
+    probe.m_records = 1;
+    Element record;
+    Random random(probe.m_seed);
+    record.generate(probe, random, 0);
+    uint64_t const record_size = serialize(record).size();
+    options.m_records = std::max<uint64_t>(1, options.m_size / record_size);
+  }
+
+  Element root;
+  {
+    Random random(options.m_seed);
+    root.generate(options, random, 0);
+  }
+
+  if (!options.m_output.empty())
+  {
+    xml::Writer writer(boost::filesystem::path(options.m_output));
+    writer.write(root);
+    return 0;
+  }
+
+  Report report(options.m_json);
+
+  std::string document;
+  double seconds = best_of(options.m_repeat, [&]{ document = serialize(root); });
+  uint64_t const bytes = document.size();
+  report.result("serialize", 1, bytes, seconds);
+
+  double parse_seconds = 1e300;
+  double deserialize_seconds = 1e300;
+  for (int i = 0; i < options.m_repeat; ++i)
+  {
+    std::istringstream iss(document);
+    xml::Reader reader;
+    auto start = std::chrono::steady_clock::now();
+    reader.parse(iss, 1);
+    auto parsed = std::chrono::steady_clock::now();
+    Element copy;
+    copy.xml(reader);
+    auto deserialized = std::chrono::steady_clock::now();
+    parse_seconds = std::min(parse_seconds, std::chrono::duration<double>(parsed - start).count());
+    deserialize_seconds = std::min(deserialize_seconds, std::chrono::duration<double>(deserialized - parsed).count());
+    if (i == 0 && serialize(copy) != document)
+    {
+      std::cerr << "Round-trip of the generated document failed!" << std::endl;
+      return 1;
+    }
+  }
+  report.result("parse", 1, bytes, parse_seconds);
+  report.result("deserialize", 1, bytes, deserialize_seconds);
+
+  // Every thread parses, deserializes and serializes its own copy of the document.
+  for (int threads = 1;; threads = std::min(threads * 2, options.m_threads))
+  {
+    seconds = best_of(options.m_repeat, [&]{
+      std::vector<std::thread> workers;
+      for (int t = 0; t < threads; ++t)
+        workers.emplace_back([&document]{
+          std::istringstream iss(document);
+          xml::Reader reader;
+          reader.parse(iss, 1);
+          Element copy;
+          copy.xml(reader);
+          std::string output = serialize(copy);
+        });
+      for (std::thread& worker : workers)
+        worker.join();
+    });
+    report.result("roundtrip", threads, bytes * threads, seconds);
+    if (threads == options.m_threads)
+      break;
+  }
+
+  report.peak_rss();
+}
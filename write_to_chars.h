@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @brief This file contains the declarations of template functions write_to_chars and append_chars.
+ *
+ * Copyright (C) 2026  Carlo Wood.
+ *
+ * RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+ * Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+namespace xml {
+
+/// The size of the buffer that must be passed to write_to_chars.
+constexpr std::size_t write_to_chars_buffer_size = 32;
+
+/**
+  * \brief Format the arithmetic value \a val into \a buf without using a stream.
+  *
+  * Integers are written in decimal, floating-point values with the shortest
+  * representation that reads back to the same value, `bool` as "true" or "false"
+  * and `char` as the character itself; the same as `operator<<` with `std::boolalpha`
+  * does, except for the precision of floating-point values.
+  *
+  * \returns A view of the formatted value inside \a buf.
+  */
+template<typename T>
+std::string_view write_to_chars(char (&buf)[write_to_chars_buffer_size], T val);
+
+/**
+  * \brief Format the arithmetic value \a val to \a first, which must have room for at least write_to_chars_buffer_size characters.
+  *
+  * \returns A pointer one past the last character written.
+  */
+template<typename T>
+char* append_chars(char* first, T val)
+{
+  static_assert(std::is_arithmetic_v<T>, "write_to_chars only supports arithmetic types.");
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    std::string_view str = val ? "true" : "false";
+    return std::copy(str.begin(), str.end(), first);
+  }
+  else if constexpr (std::is_same_v<T, char>)
+  {
+    *first = val;
+    return first + 1;
+  }
+  else
+    return std::to_chars(first, first + write_to_chars_buffer_size, val).ptr;
+}
+
+template<typename T>
+std::string_view write_to_chars(char (&buf)[write_to_chars_buffer_size], T val)
+{
+  return { buf, static_cast<std::size_t>(append_chars(buf, val) - buf) };
+}
+
+} // namespace xml
@@ -23,7 +23,6 @@
 
 #include "sys.h"
 #include "write_to_stream.h"
-#include "utils/double_to_str_precision.h"
 #include <iostream>
 
 namespace xml {
@@ -31,14 +30,15 @@ namespace xml {
 template<>
 void write_to_stream<float>(std::ostream& os, float const& val)
 {
-  os << double_to_str_precision(val, 0, 6);
+  char buf[write_to_chars_buffer_size];
+  os << write_to_chars(buf, val);
 }
 
 template<>
 void write_to_stream<double>(std::ostream& os, double const& val)
 {
-  int maxp = (val >= 0.1) ? 6 : (val >= 0.01) ? 7 : (val >= 0.001) ? 8 : 9;
-  os << double_to_str_precision(val, 0, maxp);
+  char buf[write_to_chars_buffer_size];
+  os << write_to_chars(buf, val);
 }
 
 } // namespace xml
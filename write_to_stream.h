@@ -24,6 +24,7 @@
 #pragma once
 
 #include "set_locale_for.h"
+#include "write_to_chars.h"
 
 #include <iostream>
 #include <iomanip>
@@ -57,18 +58,17 @@ void write_to_stream(std::ostream& os, T const& var)
 /**
   * \brief Specialization for `float`.
   *
-  * This functions writes a float floating-point value with a precision of six decimal places.
+  * This functions writes a float floating-point value using the shortest representation
+  * that reads back (with read_from_string or read_from_stream) to exactly the same value.
   */
 template<>
-void write_to_stream<double>(std::ostream& os, double const& val);
+void write_to_stream<float>(std::ostream& os, float const& val);
 
 /**
   * \brief Specialization for `double`.
   *
-  * This functions writes a double floating-point value with a precision that varies on it's value.
-  * The precision is normally size decimal places after the decimal point, but when if the
-  * value is smaller than 0.1 then the precision is increased to keep six significant digits
-  * up to a maximum precision of nine for values less than 0.001 (ie, 0.000999999).
+  * This functions writes a double floating-point value using the shortest representation
+  * that reads back (with read_from_string or read_from_stream) to exactly the same value.
   */
 template<>
 void write_to_stream<double>(std::ostream& os, double const& val);
@@ -77,18 +77,45 @@ void write_to_stream<double>(std::ostream& os, double const& val);
   * \brief Specialization for `std::vector<T>`.
   *
   * This functions writes the elements of the vector, using write_to_stream, space separated to the stream.
+  * Vectors of floating-point values and of integers wider than a char are formatted with append_chars
+  * into a local buffer that is written to the stream a few kilobytes at a time.
   */
 template<typename T>
 void write_to_stream(std::ostream& os, std::vector<T> const& vector)
 {
   if (vector.empty()) return;
-  auto iter = vector.begin();
-  for(;;)
+  if constexpr (std::is_floating_point_v<T> || (std::is_integral_v<T> && sizeof(T) > 1))
+  {
+    char buf[4096];
+    char* const flush_limit = buf + sizeof(buf) - write_to_chars_buffer_size - 1;
+    char* pos = buf;
+    bool first = true;
+    for (T const& val : vector)
+    {
+      // Write the separator before every element but the first, so the buffer never ends in one.
+      if (!first)
+        *pos++ = ' ';
+      first = false;
+      pos = append_chars(pos, val);
+      if (pos >= flush_limit)
+      {
+        os.write(buf, pos - buf);
+        pos = buf;
+      }
+    }
+    if (pos != buf)
+      os.write(buf, pos - buf);
+  }
+  else
   {
-    write_to_stream(os, *iter);
-    if (++iter == vector.end())
-      break;
-    os << ' ';
+    auto iter = vector.begin();
+    for(;;)
+    {
+      write_to_stream(os, *iter);
+      if (++iter == vector.end())
+        break;
+      os << ' ';
+    }
   }
 }
 
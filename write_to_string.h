@@ -23,8 +23,11 @@
 
 #pragma once
 
+#include "write_to_chars.h"
+
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
 
 namespace xml {
 
@@ -36,17 +39,26 @@ namespace xml {
   * \brief Function template to convert an object of arbitrary type to an unescaped XML string.
   *
   * The default writes \a obj to a `std::ostringstream` using `operator<<` and returns the string.
+  * Arithmetic types are formatted with write_to_chars instead.
   * Use specialization for classes that need something else for XML.
   */
 template<typename T>
 std::string write_to_string(T const& obj)
 {
-  std::ostringstream str;
-  str.flags(std::ios::boolalpha);
-  str << obj;			// error: cannot bind 'std::basic_ostream<char>' lvalue to 'std::basic_ostream<char>&&'
+  if constexpr (std::is_arithmetic_v<T>)
+  {
+    char buf[write_to_chars_buffer_size];
+    return std::string(write_to_chars(buf, obj));
+  }
+  else
+  {
+    std::ostringstream str;
+    str.flags(std::ios::boolalpha);
+    str << obj;			// error: cannot bind 'std::basic_ostream<char>' lvalue to 'std::basic_ostream<char>&&'
 				// means that there is no std::ostream& operator<<(std::ostream&, T const&) declared.
 				// Either define that, or specialize a xml::write_to_string for that type.
-  return str.str();
+    return str.str();
+  }
 }
 
 /// @}